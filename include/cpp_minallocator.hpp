@@ -10,10 +10,54 @@ publish, and distribute this file as you see fit.
 #define ALLOCATOR_HPP
 
 #include <cstdlib>   // Standard library header for memory functions
+#include <cstring>   // For std::memcpy
+#include <cstddef>   // For size_t
+#include <cstdint>   // For uint8_t, uint32_t, uint64_t
+#include <cerrno>    // For errno
 #include <cassert>   // Standard library header for assertions
+#include <bit>       // For std::countl_zero, std::countr_zero (C++20)
 #include <algorithm> // For std::min
+#include <new>       // For placement new, std::bad_alloc
+#include <utility>   // For std::forward, std::move
+#include <vector>    // For std::vector
+#include <iterator>  // For std::forward_iterator_tag
+#include <array>     // For std::array
+#include <tuple>     // For std::tuple_element_t
+#include <memory>    // For std::construct_at, std::destroy_at
+#include <cmath>     // For std::log, std::exp
+#include <cstdio>    // For std::FILE, std::fprintf
+#include <string>    // For std::string
+#include <unordered_map> // For std::unordered_map
+#include <source_location> // For std::source_location (C++20)
+#include <chrono>    // For compaction time slices
+#include <type_traits> // For std::is_trivially_copyable_v
 #include <span>      // For std::span (C++20)
 #include <concepts>  // For concepts (C++20)
+#include <mutex>     // For std::mutex, std::lock_guard
+#include <atomic>    // For std::atomic
+#include <optional>  // For std::optional
+
+#if defined(__AVX2__)
+#include <immintrin.h> // For AVX2 bitmap scans
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // For __rdtsc
+#elif defined(_M_X64)
+#include <intrin.h>    // For __rdtsc
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>  // For mmap, munmap, mremap
+#include <sys/stat.h>  // For fstat
+#include <unistd.h>    // For sysconf, ftruncate
+#include <fcntl.h>     // For open, fallocate
+#include <signal.h>    // For kill
+#endif
+
+#if defined(ALLOCATOR_PROFILE_BACKTRACE)
+#include <execinfo.h>  // For backtrace, backtrace_symbols
+#endif
 
 // Memory management macros for user-defined allocators
 #ifndef ALLOCATOR_ALLOC
@@ -24,13 +68,231 @@ publish, and distribute this file as you see fit.
 #define ALLOCATOR_FREE(ptr) std::free(ptr) // Default to free
 #endif
 
+// Define ALLOCATOR_STATS to keep usage counters in every allocator
+// Define ALLOCATOR_EVENTS to report slow allocator events to an EventSink
+
 namespace allocator {
 
+#if defined(ALLOCATOR_STATS)
+inline constexpr bool stats_enabled = true;
+#else
+inline constexpr bool stats_enabled = false;
+#endif
+
+// Snapshot of an allocator's usage counters
+struct AllocatorStats {
+    size_t allocations = 0;
+    size_t frees = 0;
+    size_t failed = 0;          // Allocations that returned nullptr or threw
+    size_t bytes_live = 0;
+    size_t high_water = 0;      // Peak of bytes_live
+    size_t blocks = 0;          // Blocks, pages or mappings currently held
+    size_t upstream_calls = 0;  // Requests to the upstream allocator or the OS
+};
+
+// Usage counters embedded in allocators. The disabled specialization is empty
+// and its members compile away; the enabled one uses plain counters, since an
+// allocator instance is only ever used from one thread at a time.
+template<bool enabled = stats_enabled>
+class StatsCounters {
+    AllocatorStats values;
+
+public:
+    constexpr void on_allocate(size_t size) noexcept {
+        ++values.allocations;
+        values.bytes_live += size;
+        values.high_water = std::max(values.high_water, values.bytes_live);
+    }
+
+    constexpr void on_free(size_t size) noexcept {
+        ++values.frees;
+        values.bytes_live -= std::min(size, values.bytes_live);
+    }
+
+    // An allocation grew or shrank in place; neither an allocation nor a free
+    constexpr void on_resize(size_t old_size, size_t new_size) noexcept {
+        values.bytes_live = values.bytes_live - std::min(old_size, values.bytes_live) + new_size;
+        values.high_water = std::max(values.high_water, values.bytes_live);
+    }
+
+    constexpr void on_failure() noexcept { ++values.failed; }
+    constexpr void on_reset() noexcept { values.bytes_live = 0; }
+    constexpr void on_block_acquired() noexcept { ++values.blocks; ++values.upstream_calls; }
+    constexpr void on_block_released() noexcept { --values.blocks; ++values.upstream_calls; }
+    constexpr void on_upstream_call() noexcept { ++values.upstream_calls; }
+
+    [[nodiscard]] constexpr AllocatorStats snapshot() const noexcept { return values; }
+};
+
+template<>
+class StatsCounters<false> {
+public:
+    constexpr void on_allocate(size_t) noexcept {}
+    constexpr void on_free(size_t) noexcept {}
+    constexpr void on_resize(size_t, size_t) noexcept {}
+    constexpr void on_failure() noexcept {}
+    constexpr void on_reset() noexcept {}
+    constexpr void on_block_acquired() noexcept {}
+    constexpr void on_block_released() noexcept {}
+    constexpr void on_upstream_call() noexcept {}
+
+    [[nodiscard]] constexpr AllocatorStats snapshot() const noexcept { return {}; }
+};
+
+#if defined(ALLOCATOR_EVENTS)
+inline constexpr bool events_enabled = true;
+#else
+inline constexpr bool events_enabled = false;
+#endif
+
+// Something an allocator did that is worth seeing on a timeline: block
+// creation ("block"), arena reset ("reset"), "trim", "mmap", "munmap",
+// mapping cache flush ("cache_flush") or "mesh"
+struct AllocatorEvent {
+    const char* name = "";
+    const void* source = nullptr;   // Allocator instance
+    size_t bytes = 0;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::nanoseconds duration{0}; // Zero for instant events
+};
+
+// Event Sink Interface
+// Receives allocator events when ALLOCATOR_EVENTS is defined, on whichever
+// thread the allocator runs.
+class EventSink {
+public:
+    virtual ~EventSink() = default;
+    virtual void on_event(const AllocatorEvent& event) noexcept = 0;
+};
+
+// Process-wide sink; nullptr (the default) drops events. Set it before
+// allocators start emitting.
+inline EventSink* event_sink = nullptr;
+
+// Report an instant event; compiles away without ALLOCATOR_EVENTS
+constexpr void emit_event(const char* name, const void* source, size_t bytes) noexcept {
+    if constexpr (events_enabled) {
+        if (!std::is_constant_evaluated() && event_sink) {
+            event_sink->on_event({name, source, bytes, std::chrono::steady_clock::now(), {}});
+        }
+    }
+}
+
+// Reports the enclosing scope as one timed event. The disabled
+// specialization is empty, like StatsCounters<false>.
+template<bool enabled = events_enabled>
+class EventScope {
+    AllocatorEvent event;
+    EventSink* sink = event_sink;
+
+public:
+    EventScope(const char* name, const void* source, size_t bytes = 0) noexcept {
+        if (sink) {
+            event.name = name;
+            event.source = source;
+            event.bytes = bytes;
+            event.start = std::chrono::steady_clock::now();
+        }
+    }
+
+    EventScope(const EventScope&) = delete;
+    EventScope& operator=(const EventScope&) = delete;
+
+    ~EventScope() {
+        if (sink) {
+            event.duration = std::chrono::steady_clock::now() - event.start;
+            sink->on_event(event);
+        }
+    }
+
+    void set_bytes(size_t bytes) noexcept { event.bytes = bytes; }
+};
+
+template<>
+class EventScope<false> {
+public:
+    constexpr EventScope(const char*, const void*, size_t = 0) noexcept {}
+    constexpr void set_bytes(size_t) noexcept {}
+};
+
+// Chrome Trace Sink Class
+// Writes events as Chrome trace-event JSON, loadable in chrome://tracing and
+// the Perfetto UI: timed events as complete ("X") events, instant events as
+// "i" events, one track per thread. mark() adds application spans such as
+// frames to the same timeline. Synchronized, so allocators on several
+// threads may share it.
+class ChromeTraceSink : public EventSink {
+    std::FILE* out;
+    std::mutex mutex;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    uint32_t thread_count = 0;
+    bool first = true;
+
+    // Small per-thread track ids, assigned on first use; called with the lock held
+    uint32_t thread_id() noexcept {
+        thread_local uint32_t id = 0;
+        if (id == 0) {
+            id = ++thread_count;
+        }
+        return id;
+    }
+
+    double micros(std::chrono::steady_clock::duration d) const noexcept {
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) / 1000.0;
+    }
+
+    void write(const char* category, const AllocatorEvent& event) noexcept {
+        std::lock_guard<std::mutex> guard(mutex);
+        std::fprintf(out, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,",
+                     first ? "" : ",", event.name, category, thread_id(), micros(event.start - epoch));
+        if (event.duration.count() > 0) {
+            std::fprintf(out, "\"ph\":\"X\",\"dur\":%.3f,", micros(event.duration));
+        } else {
+            std::fprintf(out, "\"ph\":\"i\",\"s\":\"t\",");
+        }
+        if (event.source) {
+            std::fprintf(out, "\"args\":{\"allocator\":\"%p\",\"bytes\":%zu}}", event.source, event.bytes);
+        } else {
+            std::fprintf(out, "\"args\":{}}");
+        }
+        first = false;
+    }
+
+public:
+    // Write to `file`, which the caller keeps open until the sink is destroyed
+    explicit ChromeTraceSink(std::FILE* file) : out(file) {
+        std::fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    }
+
+    ChromeTraceSink(const ChromeTraceSink&) = delete;
+    ChromeTraceSink& operator=(const ChromeTraceSink&) = delete;
+
+    ~ChromeTraceSink() override {
+        std::fprintf(out, "\n]}\n");
+        std::fflush(out);
+    }
+
+    void on_event(const AllocatorEvent& event) noexcept override {
+        write("allocator", event);
+    }
+
+    // Record an application span (a frame, a request) on the calling thread's track
+    void mark(const char* name, std::chrono::steady_clock::time_point start,
+              std::chrono::steady_clock::time_point end) noexcept {
+        AllocatorEvent span;
+        span.name = name;
+        span.start = start;
+        span.duration = end - start;
+        write("app", span);
+    }
+};
+
 // Linear Allocator Class
 class LinearAllocator {
     uint8_t* data = nullptr;
     size_t capacity = 0;
     size_t offset = 0;
+    [[no_unique_address]] StatsCounters<> counters;
 
 public:
     // Initialize allocator with memory and size
@@ -42,11 +304,13 @@ public:
 
     // Allocate memory from the allocator
     [[nodiscard]] constexpr uint8_t* allocate(size_t size) noexcept {
-        if (offset + size > capacity) {
+        if (size > capacity - offset) {
+            counters.on_failure();
             return nullptr; // Not enough space
         }
         uint8_t* ptr = data + offset;
         offset += size;
+        counters.on_allocate(size);
         return ptr;
     }
 
@@ -54,73 +318,4273 @@ public:
     constexpr void free(size_t size) noexcept {
         size = std::min(size, offset);
         offset -= size;
+        counters.on_free(size);
     }
 
     // Reset the allocator to reuse memory
     constexpr void reset() noexcept {
+        if (offset != 0) {
+            emit_event("reset", this, offset);
+        }
         offset = 0;
+        counters.on_reset();
+    }
+
+    // Usage counters; all zero unless ALLOCATOR_STATS is defined
+    [[nodiscard]] constexpr AllocatorStats stats() const noexcept {
+        return counters.snapshot();
+    }
+
+    // Start of the region and bytes handed out, for serializing it (see ArenaImageWriter)
+    [[nodiscard]] constexpr uint8_t* base() const noexcept { return data; }
+    [[nodiscard]] constexpr size_t used() const noexcept { return offset; }
+
+    // Byte allocator interface; allocations are aligned for any scalar type.
+    // Alignment padding is skipped, not counted as live bytes.
+    [[nodiscard]] uint8_t* allocate_bytes(size_t size) noexcept {
+        uintptr_t top = reinterpret_cast<uintptr_t>(data + offset);
+        size_t padding = ((top + alignof(std::max_align_t) - 1) & ~uintptr_t(alignof(std::max_align_t) - 1)) - top;
+        if (padding > capacity - offset || size > capacity - offset - padding) {
+            counters.on_failure();
+            return nullptr; // Not enough space
+        }
+        uint8_t* ptr = data + offset + padding;
+        offset += padding + size;
+        counters.on_allocate(size);
+        return ptr;
+    }
+
+    // Roll the offset back to ptr if it is the most recent allocation; otherwise a no-op
+    void deallocate_bytes(void* ptr, size_t size) noexcept {
+        if (static_cast<uint8_t*>(ptr) + size == data + offset) {
+            offset = size_t(static_cast<uint8_t*>(ptr) - data);
+            counters.on_free(size);
+        }
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept {
+        return ptr >= data && ptr < data + capacity;
     }
 };
 
-// Concept to ensure T is constructible
-template<typename T>
-concept Constructible = std::constructible_from<T>;
+// TLSF (Two-Level Segregated Fit) Allocator Class
+// Variable-size allocator over a fixed region with O(1) allocate and free.
+// Free blocks are binned by a first level (power of two) and a second level
+// (linear subdivision of that power of two); two bitmaps locate a non-empty
+// bin with a single countl_zero/countr_zero each, and freed blocks are merged
+// with their physical neighbours immediately.
+class TlsfAllocator {
+public:
+    static constexpr size_t alignment = 16;
 
-// Block Allocator Template Class
-template<Constructible T, size_t block_size = 256>
-class BlockAllocator {
+private:
+    static constexpr size_t sl_index_count_log2 = 5;
+    static constexpr size_t sl_index_count = size_t(1) << sl_index_count_log2;
+    static constexpr size_t fl_index_shift = sl_index_count_log2 + 4; // log2(alignment)
+    static constexpr size_t fl_index_max = 40;                         // Blocks up to 1 TiB
+    static constexpr size_t fl_index_count = fl_index_max - fl_index_shift + 1;
+    static constexpr size_t small_block_size = size_t(1) << fl_index_shift;
+
+    // Physical block header, padded to the alignment so payloads stay aligned
     struct Block {
-        std::span<uint8_t> mem;
+        Block* prev_phys;  // Previous block in address order (nullptr for the first)
+        size_t size;       // Payload size; bit 0 set when the block is free
+    };
+
+    // Free-list links, stored in the payload of free blocks
+    struct FreeLinks {
+        Block* next;
+        Block* prev;
+    };
+
+    static constexpr size_t header_size = alignment;
+    static constexpr size_t min_block_size = sizeof(FreeLinks) > alignment ? sizeof(FreeLinks) : alignment;
+    static constexpr size_t max_block_size = size_t(1) << fl_index_max;
+    static_assert(sizeof(Block) <= header_size);
+
+    static constexpr size_t free_bit = 1;
+
+    uint8_t* data = nullptr;
+    size_t capacity = 0;
+    [[no_unique_address]] StatsCounters<> counters;
+    uint32_t fl_bitmap = 0;
+    uint32_t sl_bitmap[fl_index_count] = {};
+    Block* free_lists[fl_index_count][sl_index_count] = {};
+
+    static constexpr size_t align_up(size_t n) noexcept {
+        return (n + alignment - 1) & ~(alignment - 1);
+    }
+
+    static size_t floor_log2(size_t n) noexcept {
+        return sizeof(size_t) * 8 - 1 - std::countl_zero(n);
+    }
+
+    static size_t size_of(const Block* block) noexcept { return block->size & ~free_bit; }
+    static bool is_free(const Block* block) noexcept { return (block->size & free_bit) != 0; }
+    static uint8_t* payload(Block* block) noexcept { return reinterpret_cast<uint8_t*>(block) + header_size; }
+
+    static FreeLinks* links(Block* block) noexcept { return reinterpret_cast<FreeLinks*>(payload(block)); }
+
+    static Block* from_payload(void* ptr) noexcept {
+        return reinterpret_cast<Block*>(static_cast<uint8_t*>(ptr) - header_size);
+    }
 
-        // Constructor to allocate memory for the block
-        Block() {
-            mem = std::span<uint8_t>(static_cast<uint8_t*>(ALLOCATOR_ALLOC(sizeof(T) * block_size)), sizeof(T) * block_size);
+    static Block* next_phys(Block* block) noexcept {
+        return reinterpret_cast<Block*>(payload(block) + size_of(block));
+    }
+
+    // Map a size to the bin that holds blocks of exactly that size class
+    static void mapping_insert(size_t size, size_t& fl, size_t& sl) noexcept {
+        if (size < small_block_size) {
+            fl = 0;
+            sl = size / (small_block_size / sl_index_count);
+        } else {
+            size_t log2 = floor_log2(size);
+            sl = (size >> (log2 - sl_index_count_log2)) ^ sl_index_count;
+            fl = log2 - (fl_index_shift - 1);
+        }
+    }
+
+    // Map a request to the first bin whose blocks are all large enough
+    static void mapping_search(size_t size, size_t& fl, size_t& sl) noexcept {
+        if (size >= small_block_size) {
+            size += (size_t(1) << (floor_log2(size) - sl_index_count_log2)) - 1;
+        }
+        mapping_insert(size, fl, sl);
+    }
+
+    void insert_free(Block* block) noexcept {
+        size_t fl, sl;
+        mapping_insert(size_of(block), fl, sl);
+        Block* head = free_lists[fl][sl];
+        links(block)->next = head;
+        links(block)->prev = nullptr;
+        if (head) {
+            links(head)->prev = block;
         }
+        free_lists[fl][sl] = block;
+        fl_bitmap |= uint32_t(1) << fl;
+        sl_bitmap[fl] |= uint32_t(1) << sl;
+    }
+
+    void remove_free(Block* block) noexcept {
+        size_t fl, sl;
+        mapping_insert(size_of(block), fl, sl);
+        FreeLinks* link = links(block);
+        if (link->prev) {
+            links(link->prev)->next = link->next;
+        } else {
+            free_lists[fl][sl] = link->next;
+        }
+        if (link->next) {
+            links(link->next)->prev = link->prev;
+        }
+        if (!free_lists[fl][sl]) {
+            sl_bitmap[fl] &= ~(uint32_t(1) << sl);
+            if (!sl_bitmap[fl]) {
+                fl_bitmap &= ~(uint32_t(1) << fl);
+            }
+        }
+    }
 
-        // Destructor to free allocated memory
-        ~Block() {
-            if (!mem.empty()) {
-                ALLOCATOR_FREE(mem.data());
+    Block* find_suitable(size_t size) noexcept {
+        size_t fl, sl;
+        mapping_search(size, fl, sl);
+        if (fl >= fl_index_count) {
+            return nullptr;
+        }
+        uint32_t sl_map = sl_bitmap[fl] & (~uint32_t(0) << sl);
+        if (!sl_map) {
+            uint32_t fl_map = fl + 1 < 32 ? fl_bitmap & (~uint32_t(0) << (fl + 1)) : 0;
+            if (!fl_map) {
+                return nullptr;
             }
+            fl = std::countr_zero(fl_map);
+            sl_map = sl_bitmap[fl];
         }
+        sl = std::countr_zero(sl_map);
+        return free_lists[fl][sl];
+    }
+
+    // Absorb the physically following block into this one
+    static void merge_next(Block* block) noexcept {
+        Block* next = next_phys(block);
+        block->size += header_size + size_of(next);
+        next_phys(block)->prev_phys = block;
+    }
+
+public:
+    // Initialize allocator with memory and size
+    void init(void* mem, size_t size) noexcept {
+        data = static_cast<uint8_t*>(mem);
+        capacity = size;
+        reset();
+    }
+
+    // Allocate memory from the allocator
+    [[nodiscard]] uint8_t* allocate(size_t size) noexcept {
+        if (size > max_block_size) {
+            counters.on_failure();
+            return nullptr; // Larger than any bin can describe
+        }
+        size = size <= min_block_size ? min_block_size : align_up(size);
+        Block* block = find_suitable(size);
+        if (!block) {
+            counters.on_failure();
+            return nullptr; // No free block large enough
+        }
+        remove_free(block);
+
+        // Split off the tail if it can hold a block of its own
+        size_t remaining = size_of(block) - size;
+        if (remaining >= header_size + min_block_size) {
+            block->size = size;
+            Block* rest = next_phys(block);
+            rest->prev_phys = block;
+            rest->size = (remaining - header_size) | free_bit;
+            next_phys(rest)->prev_phys = rest;
+            insert_free(rest);
+        } else {
+            block->size &= ~free_bit;
+        }
+        counters.on_allocate(size_of(block));
+        return payload(block);
+    }
+
+    // Return memory to the allocator, coalescing with free neighbours
+    void free(void* ptr) noexcept {
+        if (!ptr) {
+            return;
+        }
+        Block* block = from_payload(ptr);
+        assert(!is_free(block) && "TlsfAllocator: double free");
+        counters.on_free(size_of(block));
+        block->size |= free_bit;
+
+        Block* next = next_phys(block);
+        if (is_free(next)) {
+            remove_free(next);
+            merge_next(block);
+        }
+        Block* prev = block->prev_phys;
+        if (prev && is_free(prev)) {
+            remove_free(prev);
+            merge_next(prev);
+            block = prev;
+        }
+        insert_free(block);
+    }
+
+    // Reset the allocator to a single free block spanning the region
+    void reset() noexcept {
+        EventScope<> event("reset", this);
+        counters.on_reset();
+        fl_bitmap = 0;
+        std::fill_n(sl_bitmap, fl_index_count, 0u);
+        for (auto& row : free_lists) {
+            std::fill_n(row, sl_index_count, nullptr);
+        }
+
+        uintptr_t start = (reinterpret_cast<uintptr_t>(data) + alignment - 1) & ~uintptr_t(alignment - 1);
+        size_t usable = capacity > start - reinterpret_cast<uintptr_t>(data)
+            ? (capacity - (start - reinterpret_cast<uintptr_t>(data))) & ~(alignment - 1) : 0;
+        if (usable < 2 * header_size + min_block_size) {
+            return; // Region too small to hold a block and the end sentinel
+        }
+        usable = std::min(usable, max_block_size);
+
+        // One free block followed by a zero-sized, permanently used sentinel
+        Block* block = reinterpret_cast<Block*>(start);
+        block->prev_phys = nullptr;
+        block->size = (usable - 2 * header_size) | free_bit;
+        Block* sentinel = next_phys(block);
+        sentinel->prev_phys = block;
+        sentinel->size = 0;
+        insert_free(block);
+    }
+
+    // Usage counters; all zero unless ALLOCATOR_STATS is defined
+    [[nodiscard]] AllocatorStats stats() const noexcept {
+        return counters.snapshot();
+    }
+
+    // Byte allocator interface
+    [[nodiscard]] uint8_t* allocate_bytes(size_t size) noexcept {
+        return allocate(size);
+    }
+
+    void deallocate_bytes(void* ptr, size_t) noexcept {
+        free(ptr);
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept {
+        return ptr >= data && ptr < data + capacity;
+    }
+};
+
+// Search strategies for FreeListAllocator
+enum class FitPolicy {
+    FirstFit, // Take the first free block that is large enough
+    NextFit,  // Like FirstFit, but resume where the previous search stopped
+    BestFit,  // Take the smallest free block that is large enough
+};
+
+// Free block indexes for FreeListAllocator
+enum class FreeIndex {
+    AddressOrdered, // One list sorted by address; O(n) insert, good locality
+    SizeSegregated, // One unsorted list per power-of-two size class; O(1) insert
+};
+
+// Free List Allocator Template Class
+// General-purpose heap over a fixed region using boundary tags: every block
+// starts with a header holding its size, and free blocks also keep their size
+// in a footer so free() can find and merge the physically preceding block.
+template<FitPolicy fit = FitPolicy::FirstFit, FreeIndex index = FreeIndex::AddressOrdered>
+class FreeListAllocator {
+public:
+    static constexpr size_t alignment = 16;
+
+private:
+    // Header tag bits; sizes are multiples of the alignment so the low bits are spare
+    static constexpr size_t used_bit = 1;
+    static constexpr size_t prev_used_bit = 2;
+    static constexpr size_t flag_mask = alignment - 1;
+
+    // Free-list links, stored in the payload of free blocks
+    struct FreeLinks {
+        uint8_t* next;
+        uint8_t* prev;
     };
 
-    std::vector<Block> blocks;     // Vector to manage blocks of memory
-    std::vector<T*> free_list;     // Vector to manage the free list of T*
+    static constexpr size_t header_size = alignment;
+    static constexpr size_t footer_size = sizeof(size_t);
+    static constexpr size_t min_block_size =
+        (header_size + sizeof(FreeLinks) + footer_size + alignment - 1) & ~(alignment - 1);
+    static constexpr size_t bin_count = index == FreeIndex::SizeSegregated ? sizeof(size_t) * 8 : 1;
+
+    uint8_t* data = nullptr;
+    size_t capacity = 0;
+    size_t free_total = 0;
+    [[no_unique_address]] StatsCounters<> counters;
+    uint8_t* heads[bin_count] = {};
+    uint8_t* rovers[bin_count] = {};  // Next-fit resume points, one per list
+
+    static size_t& tag(uint8_t* block) noexcept { return *reinterpret_cast<size_t*>(block); }
+    static size_t size_of(uint8_t* block) noexcept { return tag(block) & ~flag_mask; }
+    static bool is_used(uint8_t* block) noexcept { return (tag(block) & used_bit) != 0; }
+    static FreeLinks* links(uint8_t* block) noexcept { return reinterpret_cast<FreeLinks*>(block + header_size); }
+    static size_t& footer(uint8_t* block) noexcept {
+        return *reinterpret_cast<size_t*>(block + size_of(block) - footer_size);
+    }
+
+    static size_t bin_of(size_t size) noexcept {
+        if constexpr (bin_count == 1) {
+            return 0;
+        } else {
+            return sizeof(size_t) * 8 - 1 - std::countl_zero(size | 1);
+        }
+    }
+
+    // Write a free block's header and footer and clear the next block's prev_used bit
+    static void mark_free(uint8_t* block, size_t size, size_t prev_used) noexcept {
+        tag(block) = size | prev_used;
+        footer(block) = size;
+        tag(block + size) &= ~prev_used_bit;
+    }
+
+    void insert_free(uint8_t* block) noexcept {
+        size_t bin = bin_of(size_of(block));
+        uint8_t* prev = nullptr;
+        uint8_t* next = heads[bin];
+        if constexpr (index == FreeIndex::AddressOrdered) {
+            while (next && next < block) {
+                prev = next;
+                next = links(next)->next;
+            }
+        }
+        links(block)->prev = prev;
+        links(block)->next = next;
+        if (prev) {
+            links(prev)->next = block;
+        } else {
+            heads[bin] = block;
+        }
+        if (next) {
+            links(next)->prev = block;
+        }
+        free_total += size_of(block);
+    }
+
+    void remove_free(uint8_t* block) noexcept {
+        size_t bin = bin_of(size_of(block));
+        FreeLinks* link = links(block);
+        if (rovers[bin] == block) {
+            rovers[bin] = link->next;
+        }
+        if (link->prev) {
+            links(link->prev)->next = link->next;
+        } else {
+            heads[bin] = link->next;
+        }
+        if (link->next) {
+            links(link->next)->prev = link->prev;
+        }
+        free_total -= size_of(block);
+    }
+
+    // Search one free list according to the fit policy
+    uint8_t* search_list(size_t bin, size_t size) noexcept {
+        if constexpr (fit == FitPolicy::FirstFit) {
+            for (uint8_t* block = heads[bin]; block; block = links(block)->next) {
+                if (size_of(block) >= size) {
+                    return block;
+                }
+            }
+            return nullptr;
+        } else if constexpr (fit == FitPolicy::NextFit) {
+            uint8_t* start = rovers[bin] ? rovers[bin] : heads[bin];
+            for (uint8_t* block = start; block; block = links(block)->next) {
+                if (size_of(block) >= size) {
+                    return block;
+                }
+            }
+            for (uint8_t* block = heads[bin]; block && block != start; block = links(block)->next) {
+                if (size_of(block) >= size) {
+                    return block;
+                }
+            }
+            return nullptr;
+        } else {
+            uint8_t* best = nullptr;
+            for (uint8_t* block = heads[bin]; block; block = links(block)->next) {
+                size_t block_size = size_of(block);
+                if (block_size >= size && (!best || block_size < size_of(best))) {
+                    best = block;
+                    if (block_size == size) {
+                        break; // Exact fit cannot be beaten
+                    }
+                }
+            }
+            return best;
+        }
+    }
+
+    uint8_t* find_free(size_t size) noexcept {
+        // Size classes are disjoint and increasing, so the first class with a
+        // fit also holds the globally best fit
+        for (size_t bin = bin_of(size); bin < bin_count; ++bin) {
+            if (uint8_t* block = search_list(bin, size)) {
+                return block;
+            }
+        }
+        return nullptr;
+    }
 
 public:
-    // Allocate an object of type T
-    template<typename... Args>
-    [[nodiscard]] T* allocate(Args&&... args) {
-        if (free_list.empty()) {
-            Block& block = blocks.emplace_back();
-            T* ptr = reinterpret_cast<T*>(block.mem.data());
-            for (size_t i = 0; i < block_size; ++i) {
-                free_list.push_back(ptr + i);
+    // Initialize allocator with memory and size
+    void init(void* mem, size_t size) noexcept {
+        data = static_cast<uint8_t*>(mem);
+        capacity = size;
+        reset();
+    }
+
+    // Allocate memory from the allocator
+    [[nodiscard]] uint8_t* allocate(size_t size) noexcept {
+        if (size > capacity) {
+            counters.on_failure();
+            return nullptr; // Can never fit; also keeps the rounding below from overflowing
+        }
+        size = std::max((header_size + size + alignment - 1) & ~(alignment - 1), min_block_size);
+        uint8_t* block = find_free(size);
+        if (!block) {
+            counters.on_failure();
+            return nullptr; // No free block large enough
+        }
+        if constexpr (fit == FitPolicy::NextFit) {
+            rovers[bin_of(size_of(block))] = links(block)->next; // Resume after this block
+        }
+        remove_free(block);
+
+        // Split off the tail if it can hold a block of its own
+        size_t block_size = size_of(block);
+        size_t prev_used = tag(block) & prev_used_bit;
+        if (block_size - size >= min_block_size) {
+            uint8_t* rest = block + size;
+            mark_free(rest, block_size - size, prev_used_bit);
+            insert_free(rest);
+            if constexpr (fit == FitPolicy::NextFit) {
+                rovers[bin_of(size_of(rest))] = rest;
             }
+            block_size = size;
         }
-        T* ptr = free_list.back();
-        free_list.pop_back();
-        return new (ptr) T(std::forward<Args>(args)...); // Construct in-place
+        tag(block) = block_size | used_bit | prev_used;
+        tag(block + block_size) |= prev_used_bit;
+        counters.on_allocate(block_size);
+        return block + header_size;
     }
 
-    // Free an object of type T
-    void free(T* ptr) {
-        ptr->~T(); // Explicitly call the destructor
-        free_list.push_back(ptr);
+    // Return memory to the allocator, coalescing with free neighbours
+    void free(void* ptr) noexcept {
+        if (!ptr) {
+            return;
+        }
+        uint8_t* block = static_cast<uint8_t*>(ptr) - header_size;
+        assert(is_used(block) && "FreeListAllocator: double free");
+        size_t size = size_of(block);
+        counters.on_free(size);
+
+        uint8_t* next = block + size;
+        if (!is_used(next)) {
+            remove_free(next);
+            size += size_of(next);
+        }
+        if (!(tag(block) & prev_used_bit)) {
+            uint8_t* prev = block - *reinterpret_cast<size_t*>(block - footer_size);
+            remove_free(prev);
+            size += size_of(prev);
+            block = prev;
+        }
+        mark_free(block, size, tag(block) & prev_used_bit);
+        insert_free(block);
     }
 
-    // Destructor to clean up all blocks
-    ~BlockAllocator() {
-        for (auto& block : blocks) {
-            for (size_t i = 0; i < block_size; ++i) {
-                T* ptr = reinterpret_cast<T*>(block.mem.data()) + i;
-                ptr->~T();
+    // Reset the allocator to a single free block spanning the region
+    void reset() noexcept {
+        EventScope<> event("reset", this);
+        counters.on_reset();
+        std::fill_n(heads, bin_count, nullptr);
+        std::fill_n(rovers, bin_count, nullptr);
+        free_total = 0;
+
+        uintptr_t start = (reinterpret_cast<uintptr_t>(data) + alignment - 1) & ~uintptr_t(alignment - 1);
+        size_t usable = capacity > start - reinterpret_cast<uintptr_t>(data)
+            ? (capacity - (start - reinterpret_cast<uintptr_t>(data))) & ~(alignment - 1) : 0;
+        if (usable < min_block_size + header_size) {
+            return; // Region too small to hold a block and the end sentinel
+        }
+
+        // One free block followed by a zero-sized, permanently used sentinel
+        uint8_t* block = reinterpret_cast<uint8_t*>(start);
+        size_t size = usable - header_size;
+        tag(block + size) = used_bit;
+        mark_free(block, size, prev_used_bit);
+        insert_free(block);
+    }
+
+    // Total bytes held by free blocks, headers included
+    [[nodiscard]] size_t free_bytes() const noexcept {
+        return free_total;
+    }
+
+    // Size of the largest free block; walks every free list
+    [[nodiscard]] size_t largest_free_block() const noexcept {
+        size_t largest = 0;
+        for (uint8_t* head : heads) {
+            for (uint8_t* block = head; block; block = links(block)->next) {
+                largest = std::max(largest, size_of(block));
             }
         }
+        return largest;
+    }
+
+    // Number of free blocks; walks every free list
+    [[nodiscard]] size_t free_block_count() const noexcept {
+        size_t count = 0;
+        for (uint8_t* head : heads) {
+            for (uint8_t* block = head; block; block = links(block)->next) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    // Usage counters; all zero unless ALLOCATOR_STATS is defined
+    [[nodiscard]] AllocatorStats stats() const noexcept {
+        return counters.snapshot();
+    }
+
+    // Byte allocator interface
+    [[nodiscard]] uint8_t* allocate_bytes(size_t size) noexcept {
+        return allocate(size);
+    }
+
+    void deallocate_bytes(void* ptr, size_t) noexcept {
+        free(ptr);
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept {
+        return ptr >= data && ptr < data + capacity;
     }
 };
 
+// Page Allocator Template Class
+// Hands out fixed-size pages of a region, singly or as contiguous runs. One
+// bit per page (set = free) lets searches skip 64 pages per word with
+// countr_zero/countr_one, and fully used stretches 256 pages at a time with
+// AVX2 when it is available.
+template<size_t page_size = 4096>
+class PageAllocator {
+    static_assert(std::has_single_bit(page_size), "page_size must be a power of two");
+
+    uint8_t* data = nullptr;
+    size_t page_count = 0;
+    size_t free_count = 0;
+    size_t search_hint = 0;          // No free page lives in a word below this one
+    std::vector<uint64_t> bitmap;    // Bit set when the page is free
+    [[no_unique_address]] StatsCounters<> counters;
+
+    // Index of the first word at or after `word` that has a free page
+    size_t next_free_word(size_t word) const noexcept {
+#if defined(__AVX2__)
+        for (; word + 4 <= bitmap.size(); word += 4) {
+            __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bitmap.data() + word));
+            if (!_mm256_testz_si256(bits, bits)) {
+                break;
+            }
+        }
+#endif
+        while (word < bitmap.size() && bitmap[word] == 0) {
+            ++word;
+        }
+        return word;
+    }
+
+    // Find the first run of `count` free pages; returns page_count if none
+    size_t find_run(size_t count) const noexcept {
+        size_t run_start = 0;
+        size_t run_length = 0;
+        for (size_t word = next_free_word(search_hint); word < bitmap.size(); ++word) {
+            uint64_t bits = bitmap[word];
+            if (bits == 0) {
+                // A used word breaks any run; jump to the next word with a free page
+                run_length = 0;
+                word = next_free_word(word) - 1;
+                continue;
+            }
+            size_t bit = 0;
+            while (bit < 64) {
+                uint64_t rest = bits >> bit;
+                if (rest == 0) {
+                    run_length = 0; // Remaining pages of this word are used
+                    break;
+                }
+                size_t used = std::countr_zero(rest);
+                if (used) {
+                    run_length = 0;
+                    bit += used;
+                    rest >>= used;
+                }
+                size_t free = std::countr_one(rest);
+                if (run_length == 0) {
+                    run_start = word * 64 + bit;
+                }
+                run_length += free;
+                bit += free;
+                if (run_length >= count) {
+                    return run_start;
+                }
+            }
+        }
+        return page_count;
+    }
+
+    // Set (free) or clear (allocate) the bits of pages [first, first + count)
+    void mark(size_t first, size_t count, bool free) noexcept {
+        while (count > 0) {
+            size_t word = first / 64;
+            size_t bit = first % 64;
+            size_t span = std::min<size_t>(64 - bit, count);
+            uint64_t mask = (span == 64 ? ~uint64_t(0) : ((uint64_t(1) << span) - 1)) << bit;
+            assert(free ? (bitmap[word] & mask) == 0 : (bitmap[word] & mask) == mask);
+            if (free) {
+                bitmap[word] |= mask;
+            } else {
+                bitmap[word] &= ~mask;
+            }
+            first += span;
+            count -= span;
+        }
+    }
+
+public:
+    // Initialize allocator with memory and size; the region should be page aligned
+    void init(void* mem, size_t size) {
+        data = static_cast<uint8_t*>(mem);
+        page_count = size / page_size;
+        bitmap.assign((page_count + 63) / 64, 0);
+        reset();
+    }
+
+    // Allocate a single page
+    [[nodiscard]] uint8_t* allocate() noexcept {
+        size_t word = next_free_word(search_hint);
+        if (word >= bitmap.size()) {
+            counters.on_failure();
+            return nullptr; // Out of pages
+        }
+        search_hint = word;
+        size_t page = word * 64 + std::countr_zero(bitmap[word]);
+        bitmap[word] &= bitmap[word] - 1; // Clear the lowest set bit
+        --free_count;
+        counters.on_allocate(page_size);
+        return data + page * page_size;
+    }
+
+    // Allocate `count` contiguous pages
+    [[nodiscard]] uint8_t* allocate_run(size_t count) noexcept {
+        if (count == 0 || count > free_count) {
+            counters.on_failure();
+            return nullptr;
+        }
+        if (count == 1) {
+            return allocate();
+        }
+        size_t first = find_run(count);
+        if (first == page_count) {
+            counters.on_failure();
+            return nullptr; // No run long enough
+        }
+        mark(first, count, false);
+        free_count -= count;
+        counters.on_allocate(count * page_size);
+        return data + first * page_size;
+    }
+
+    // Free a single page
+    void free(void* ptr) noexcept {
+        free_run(ptr, 1);
+    }
+
+    // Free a run of `count` pages starting at ptr
+    void free_run(void* ptr, size_t count) noexcept {
+        if (!ptr) {
+            return;
+        }
+        size_t first = size_t(static_cast<uint8_t*>(ptr) - data) / page_size;
+        assert(first + count <= page_count);
+        mark(first, count, true);
+        free_count += count;
+        counters.on_free(count * page_size);
+        search_hint = std::min(search_hint, first / 64);
+    }
+
+    // Byte-sized interface so the allocator can supply BlockAllocator blocks
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept {
+        return allocate_run((size + page_size - 1) / page_size);
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept {
+        free_run(ptr, (size + page_size - 1) / page_size);
+    }
+
+    // Mark every page free
+    void reset() noexcept {
+        std::fill(bitmap.begin(), bitmap.end(), ~uint64_t(0));
+        if (page_count % 64) {
+            bitmap.back() = (uint64_t(1) << (page_count % 64)) - 1; // Padding bits stay used
+        }
+        free_count = page_count;
+        search_hint = 0;
+        counters.on_reset();
+    }
+
+    // Number of pages currently free
+    [[nodiscard]] size_t free_pages() const noexcept {
+        return free_count;
+    }
+
+    // Usage counters; all zero unless ALLOCATOR_STATS is defined
+    [[nodiscard]] AllocatorStats stats() const noexcept {
+        return counters.snapshot();
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept {
+        return ptr >= data && ptr < data + page_count * page_size;
+    }
+};
+
+// Concept to ensure T is constructible
+template<typename T>
+concept Constructible = std::constructible_from<T>;
+
+// Concept for byte allocators: sources of pool blocks and the building
+// blocks of composed allocators. allocate_bytes returns nullptr on failure.
+template<typename A>
+concept RawAllocator = requires(A& allocator, void* ptr, size_t size) {
+    { allocator.allocate_bytes(size) } -> std::convertible_to<void*>;
+    allocator.deallocate_bytes(ptr, size);
+};
+
+// Byte allocator that can tell whether it handed out a pointer
+template<typename A>
+concept OwningAllocator = RawAllocator<A> && requires(const A& allocator, const void* ptr) {
+    { allocator.owns(ptr) } -> std::same_as<bool>;
+};
+
+// Default block source using the ALLOCATOR_ALLOC / ALLOCATOR_FREE macros
+struct DefaultUpstream {
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept {
+        return ALLOCATOR_ALLOC(size);
+    }
+
+    void deallocate_bytes(void* ptr, size_t) noexcept {
+        ALLOCATOR_FREE(ptr);
+    }
+};
+
+// Non-owning reference to another allocator, for use as an upstream
+template<typename A>
+class UpstreamRef {
+    A* target;
+
+public:
+    explicit UpstreamRef(A& allocator) noexcept : target(&allocator) {}
+
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept(noexcept(target->allocate_bytes(size))) {
+        return target->allocate_bytes(size);
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept(noexcept(target->deallocate_bytes(ptr, size))) {
+        target->deallocate_bytes(ptr, size);
+    }
+};
+
+// Child Arena Template Class
+// A LinearAllocator whose region is carved from a parent allocator (a level
+// arena, another ChildArena, a TLSF heap) and handed back in one
+// deallocate_bytes call on destruction, so per-subsystem and per-request
+// arenas nest without trips to the OS. Child pools take their blocks from a
+// child arena through UpstreamRef. With a linear parent, destroy children in
+// reverse order of creation (scoping does this) for the parent to reclaim them.
+template<RawAllocator Parent>
+class ChildArena {
+    Parent* parent;
+    void* region;
+    size_t region_size;
+    LinearAllocator arena;
+
+public:
+    // Take `size` bytes from parent; throws std::bad_alloc if it cannot supply them
+    ChildArena(Parent& parent_allocator, size_t size)
+        : parent(&parent_allocator),
+          // Whole max_align_t units, so a linear parent stays aligned for its next child
+          region_size((size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1)) {
+        region = parent->allocate_bytes(region_size);
+        if (!region) {
+            throw std::bad_alloc();
+        }
+        arena.init(region, region_size);
+    }
+
+    ChildArena(const ChildArena&) = delete;
+    ChildArena& operator=(const ChildArena&) = delete;
+
+    ~ChildArena() {
+        parent->deallocate_bytes(region, region_size);
+    }
+
+    [[nodiscard]] uint8_t* allocate(size_t size) noexcept { return arena.allocate(size); }
+    void free(size_t size) noexcept { arena.free(size); }
+    void reset() noexcept { arena.reset(); }
+
+    [[nodiscard]] uint8_t* allocate_bytes(size_t size) noexcept { return arena.allocate_bytes(size); }
+    void deallocate_bytes(void* ptr, size_t size) noexcept { arena.deallocate_bytes(ptr, size); }
+    [[nodiscard]] bool owns(const void* ptr) const noexcept { return arena.owns(ptr); }
+
+    [[nodiscard]] size_t capacity() const noexcept { return region_size; }
+    [[nodiscard]] AllocatorStats stats() const noexcept { return arena.stats(); }
+};
+
+// Fixed Size Pool Template Class
+// Type-erased pool of equally sized slots; BlockAllocator is built on it. Pools
+// are keyed only by slot size and alignment, so one pool can serve every type
+// with that layout (see shared_pool).
+template<size_t size, size_t align = alignof(std::max_align_t), size_t block_size = 256,
+         RawAllocator Upstream = DefaultUpstream>
+class FixedSizePool {
+    static_assert(std::has_single_bit(align), "align must be a power of two");
+
+public:
+    static constexpr size_t slot_size = (size + align - 1) & ~(align - 1);
+
+private:
+    // Upstreams only promise malloc alignment; over-allocate to align by hand
+    static constexpr size_t padding = align > alignof(std::max_align_t) ? align : 0;
+    static constexpr size_t block_bytes = slot_size * block_size + padding;
+
+    std::vector<uint8_t*> blocks;  // Vector to manage blocks of memory, as returned upstream
+    std::vector<void*> free_list;  // Vector to manage the free slots
+    Upstream upstream;             // Source of block memory
+    [[no_unique_address]] StatsCounters<> counters;
+
+    static uint8_t* first_slot(uint8_t* mem) noexcept {
+        return reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(mem) + align - 1) & ~uintptr_t(align - 1));
+    }
+
+public:
+    FixedSizePool() = default;
+
+    // Take block memory from the given upstream
+    explicit FixedSizePool(Upstream source) : upstream(std::move(source)) {}
+
+    FixedSizePool(const FixedSizePool&) = delete;
+    FixedSizePool& operator=(const FixedSizePool&) = delete;
+
+    // Allocate one uninitialized slot
+    [[nodiscard]] void* allocate() {
+        if (free_list.empty()) {
+            EventScope<> event("block", this, block_bytes);
+            blocks.reserve(blocks.size() + 1);
+            free_list.reserve((blocks.size() + 1) * block_size); // So free() never reallocates
+            auto* mem = static_cast<uint8_t*>(upstream.allocate_bytes(block_bytes));
+            if (!mem) {
+                counters.on_failure();
+                throw std::bad_alloc();
+            }
+            counters.on_block_acquired();
+            blocks.push_back(mem);
+            uint8_t* slots = first_slot(mem);
+            for (size_t i = block_size; i-- > 0;) {
+                free_list.push_back(slots + i * slot_size); // Hand out slots in address order
+            }
+        }
+        void* ptr = free_list.back();
+        free_list.pop_back();
+        counters.on_allocate(slot_size);
+        return ptr;
+    }
+
+    // Return a slot to the pool
+    void free(void* ptr) noexcept {
+        free_list.push_back(ptr);
+        counters.on_free(slot_size);
+    }
+
+    // Usage counters; all zero unless ALLOCATOR_STATS is defined
+    [[nodiscard]] AllocatorStats stats() const noexcept {
+        return counters.snapshot();
+    }
+
+    // Byte allocator interface; requests larger than a slot fail
+    [[nodiscard]] void* allocate_bytes(size_t bytes) noexcept {
+        if (bytes > slot_size) {
+            return nullptr;
+        }
+        try {
+            return allocate();
+        } catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+    }
+
+    void deallocate_bytes(void* ptr, size_t) noexcept {
+        free(ptr);
+    }
+
+    // Whether ptr is a slot of this pool; walks the blocks
+    [[nodiscard]] bool owns(const void* ptr) const noexcept {
+        auto* p = static_cast<const uint8_t*>(ptr);
+        for (uint8_t* mem : blocks) {
+            const uint8_t* slots = first_slot(mem);
+            if (p >= slots && p < slots + slot_size * block_size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Visit every slot that is currently allocated
+    template<typename F>
+    void for_each_allocated(F&& f) {
+        std::sort(free_list.begin(), free_list.end());
+        for (uint8_t* mem : blocks) {
+            uint8_t* slots = first_slot(mem);
+            for (size_t i = 0; i < block_size; ++i) {
+                void* ptr = slots + i * slot_size;
+                if (!std::binary_search(free_list.begin(), free_list.end(), ptr)) {
+                    f(ptr);
+                }
+            }
+        }
+    }
+
+    // Destructor to return all blocks
+    ~FixedSizePool() {
+        for (uint8_t* mem : blocks) {
+            upstream.deallocate_bytes(mem, block_bytes);
+        }
+    }
+};
+
+// Process-wide pool for one slot size and alignment, shared by every user of
+// that layout. Keyed on the slot size after rounding, so requests that end up
+// in equal slots share a pool. Like the other allocators here it is not
+// synchronized.
+template<size_t size, size_t align>
+[[nodiscard]] FixedSizePool<FixedSizePool<size, align>::slot_size, align>& shared_pool() noexcept {
+    if constexpr (size != FixedSizePool<size, align>::slot_size) {
+        return shared_pool<FixedSizePool<size, align>::slot_size, align>();
+    } else {
+        static FixedSizePool<size, align> pool;
+        return pool;
+    }
+}
+
+// Block Allocator Template Class
+template<Constructible T, size_t block_size = 256, RawAllocator Upstream = DefaultUpstream>
+class BlockAllocator {
+public:
+    using Pool = FixedSizePool<sizeof(T), alignof(T), block_size, Upstream>;
+
+private:
+    std::optional<Pool> own_pool;  // Empty when a shared pool is given
+    Pool* pool;
+
+public:
+    BlockAllocator() : own_pool(std::in_place), pool(&*own_pool) {}
+
+    // Take block memory from the given upstream
+    explicit BlockAllocator(Upstream upstream) : own_pool(std::in_place, std::move(upstream)), pool(&*own_pool) {}
+
+    // Delegate to a pool shared with other allocators, e.g. shared_pool<sizeof(T), alignof(T)>().
+    // Objects still live when this allocator is destroyed are left to the pool.
+    explicit BlockAllocator(Pool& shared) noexcept : pool(&shared) {}
+
+    BlockAllocator(const BlockAllocator&) = delete;
+    BlockAllocator& operator=(const BlockAllocator&) = delete;
+
+    // Allocate an object of type T
+    template<typename... Args>
+    [[nodiscard]] T* allocate(Args&&... args) {
+        void* ptr = pool->allocate();
+        try {
+            return new (ptr) T(std::forward<Args>(args)...); // Construct in-place
+        } catch (...) {
+            pool->free(ptr);
+            throw;
+        }
+    }
+
+    // Free an object of type T
+    void free(T* ptr) {
+        ptr->~T(); // Explicitly call the destructor
+        pool->free(ptr);
+    }
+
+    // Byte allocator interface handing out raw slots; requests larger than T fail
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept {
+        return pool->allocate_bytes(size);
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept {
+        pool->deallocate_bytes(ptr, size);
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept {
+        return pool->owns(ptr);
+    }
+
+    // Usage counters of the underlying pool, which may be shared
+    [[nodiscard]] AllocatorStats stats() const noexcept {
+        return pool->stats();
+    }
+
+    // Destructor to destroy live objects; the pool returns the blocks
+    ~BlockAllocator() {
+        if (own_pool) {
+            own_pool->for_each_allocated([](void* ptr) { static_cast<T*>(ptr)->~T(); });
+        }
+    }
+};
+
+// Allocator composition building blocks
+//
+// Each block is itself a RawAllocator, so they nest freely, e.g.
+//
+//     Segregator<256, FallbackAllocator<LinearAllocator, TlsfAllocator>, LargeObjectAllocator>
+//
+// All dispatch is resolved at compile time and inlines into the caller.
+
+// Segregator Template Class
+// Sends requests of up to `threshold` bytes to Small and larger ones to Large.
+template<size_t threshold, RawAllocator Small, RawAllocator Large>
+class Segregator {
+    [[no_unique_address]] Small small_alloc;
+    [[no_unique_address]] Large large_alloc;
+
+public:
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept(noexcept(small_alloc.allocate_bytes(size)) &&
+                                                              noexcept(large_alloc.allocate_bytes(size))) {
+        return size <= threshold ? static_cast<void*>(small_alloc.allocate_bytes(size))
+                                 : static_cast<void*>(large_alloc.allocate_bytes(size));
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept(noexcept(small_alloc.deallocate_bytes(ptr, size)) &&
+                                                           noexcept(large_alloc.deallocate_bytes(ptr, size))) {
+        if (size <= threshold) {
+            small_alloc.deallocate_bytes(ptr, size);
+        } else {
+            large_alloc.deallocate_bytes(ptr, size);
+        }
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept(noexcept(small_alloc.owns(ptr)) && noexcept(large_alloc.owns(ptr)))
+        requires OwningAllocator<Small> && OwningAllocator<Large> {
+        return small_alloc.owns(ptr) || large_alloc.owns(ptr);
+    }
+
+    Small& small() noexcept { return small_alloc; }
+    Large& large() noexcept { return large_alloc; }
+};
+
+// Fallback Allocator Template Class
+// Tries Primary first and uses Fallback when it fails; frees go to whichever owns the pointer.
+template<OwningAllocator Primary, RawAllocator Fallback>
+class FallbackAllocator {
+    [[no_unique_address]] Primary primary_alloc;
+    [[no_unique_address]] Fallback fallback_alloc;
+
+public:
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept(noexcept(primary_alloc.allocate_bytes(size)) &&
+                                                              noexcept(fallback_alloc.allocate_bytes(size))) {
+        if (void* ptr = primary_alloc.allocate_bytes(size)) {
+            return ptr;
+        }
+        return fallback_alloc.allocate_bytes(size);
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept(noexcept(primary_alloc.owns(ptr)) &&
+                                                           noexcept(primary_alloc.deallocate_bytes(ptr, size)) &&
+                                                           noexcept(fallback_alloc.deallocate_bytes(ptr, size))) {
+        if (primary_alloc.owns(ptr)) {
+            primary_alloc.deallocate_bytes(ptr, size);
+        } else {
+            fallback_alloc.deallocate_bytes(ptr, size);
+        }
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const
+        noexcept(noexcept(primary_alloc.owns(ptr)) && noexcept(fallback_alloc.owns(ptr))) requires OwningAllocator<Fallback> {
+        return primary_alloc.owns(ptr) || fallback_alloc.owns(ptr);
+    }
+
+    Primary& primary() noexcept { return primary_alloc; }
+    Fallback& fallback() noexcept { return fallback_alloc; }
+};
+
+// Bucketizer Template Class
+// One A per size bucket of `step` bytes covering (min_size, max_size]; other sizes fail.
+template<RawAllocator A, size_t min_size, size_t max_size, size_t step>
+class Bucketizer {
+    static_assert(max_size > min_size && (max_size - min_size) % step == 0);
+
+public:
+    static constexpr size_t bucket_count = (max_size - min_size) / step;
+
+private:
+    std::array<A, bucket_count> buckets;
+
+    static constexpr size_t bucket_of(size_t size) noexcept {
+        return (size - min_size - 1) / step;
+    }
+
+public:
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept(noexcept(buckets[0].allocate_bytes(size))) {
+        if (size <= min_size || size > max_size) {
+            return nullptr;
+        }
+        return buckets[bucket_of(size)].allocate_bytes(size);
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept(noexcept(buckets[0].deallocate_bytes(ptr, size))) {
+        buckets[bucket_of(size)].deallocate_bytes(ptr, size);
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept(noexcept(buckets[0].owns(ptr))) requires OwningAllocator<A> {
+        return std::any_of(buckets.begin(), buckets.end(), [ptr](const A& a) { return a.owns(ptr); });
+    }
+
+    // Allocator serving sizes (min_size + i * step, min_size + (i + 1) * step]
+    A& bucket(size_t i) noexcept { return buckets[i]; }
+};
+
+// Counters kept by StatsAllocator
+struct CompositionStats {
+    size_t allocations = 0;
+    size_t deallocations = 0;
+    size_t failed = 0;
+    size_t bytes_allocated = 0;   // Total over the allocator's lifetime
+    size_t bytes_live = 0;
+    size_t bytes_peak = 0;
+};
+
+// Stats Allocator Template Class
+// Forwards to A and counts calls and bytes, whether or not ALLOCATOR_STATS is defined.
+template<RawAllocator A>
+class StatsAllocator {
+    [[no_unique_address]] A inner_alloc;
+    CompositionStats counters;
+
+public:
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept(noexcept(inner_alloc.allocate_bytes(size))) {
+        void* ptr = inner_alloc.allocate_bytes(size);
+        if (!ptr) {
+            ++counters.failed;
+            return nullptr;
+        }
+        ++counters.allocations;
+        counters.bytes_allocated += size;
+        counters.bytes_live += size;
+        counters.bytes_peak = std::max(counters.bytes_peak, counters.bytes_live);
+        return ptr;
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept(noexcept(inner_alloc.deallocate_bytes(ptr, size))) {
+        ++counters.deallocations;
+        counters.bytes_live -= size;
+        inner_alloc.deallocate_bytes(ptr, size);
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept(noexcept(inner_alloc.owns(ptr))) requires OwningAllocator<A> {
+        return inner_alloc.owns(ptr);
+    }
+
+    [[nodiscard]] const CompositionStats& stats() const noexcept { return counters; }
+    A& inner() noexcept { return inner_alloc; }
+};
+
+// Affix Allocator Template Class
+// Stores a Prefix object before and an optional Suffix object after each
+// allocation (for headers, guards, tags). Payloads keep max_align_t alignment.
+template<RawAllocator A, typename Prefix, typename Suffix = void>
+class AffixAllocator {
+    static_assert(std::is_void_v<Prefix> || alignof(Prefix) <= alignof(std::max_align_t));
+
+    static constexpr size_t align_to(size_t n, size_t a) noexcept { return (n + a - 1) & ~(a - 1); }
+
+    static constexpr size_t prefix_size =
+        std::is_void_v<Prefix> ? 0 : align_to(sizeof(std::conditional_t<std::is_void_v<Prefix>, char, Prefix>),
+                                              alignof(std::max_align_t));
+    static constexpr size_t suffix_alignment =
+        alignof(std::conditional_t<std::is_void_v<Suffix>, char, Suffix>);
+    static constexpr size_t suffix_size =
+        std::is_void_v<Suffix> ? 0 : sizeof(std::conditional_t<std::is_void_v<Suffix>, char, Suffix>);
+
+    static constexpr size_t total_size(size_t size) noexcept {
+        return std::is_void_v<Suffix> ? prefix_size + size
+                                      : align_to(prefix_size + size, suffix_alignment) + suffix_size;
+    }
+
+    [[no_unique_address]] A inner_alloc;
+
+public:
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept(noexcept(inner_alloc.allocate_bytes(size))) {
+        auto* mem = static_cast<uint8_t*>(inner_alloc.allocate_bytes(total_size(size)));
+        if (!mem) {
+            return nullptr;
+        }
+        if constexpr (!std::is_void_v<Prefix>) {
+            new (mem) Prefix();
+        }
+        if constexpr (!std::is_void_v<Suffix>) {
+            new (mem + align_to(prefix_size + size, suffix_alignment)) Suffix();
+        }
+        return mem + prefix_size;
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept(noexcept(inner_alloc.deallocate_bytes(ptr, size))) {
+        auto* mem = static_cast<uint8_t*>(ptr) - prefix_size;
+        if constexpr (!std::is_void_v<Suffix>) {
+            std::destroy_at(&suffix(ptr, size));
+        }
+        if constexpr (!std::is_void_v<Prefix>) {
+            std::destroy_at(&prefix(ptr));
+        }
+        inner_alloc.deallocate_bytes(mem, total_size(size));
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept(noexcept(inner_alloc.owns(ptr))) requires OwningAllocator<A> {
+        return inner_alloc.owns(static_cast<const uint8_t*>(ptr) - prefix_size);
+    }
+
+    // The prefix object of an allocation
+    template<typename P = Prefix>
+    requires (!std::is_void_v<P>)
+    static P& prefix(void* ptr) noexcept {
+        return *std::launder(reinterpret_cast<P*>(static_cast<uint8_t*>(ptr) - prefix_size));
+    }
+
+    // The suffix object of an allocation of `size` bytes
+    template<typename S = Suffix>
+    requires (!std::is_void_v<S>)
+    static S& suffix(void* ptr, size_t size) noexcept {
+        uint8_t* mem = static_cast<uint8_t*>(ptr) - prefix_size;
+        return *std::launder(reinterpret_cast<S*>(mem + align_to(prefix_size + size, suffix_alignment)));
+    }
+
+    A& inner() noexcept { return inner_alloc; }
+};
+
+// Locked Allocator Template Class
+// Serializes every call into A with a Mutex so one instance can be shared
+// between threads. Also BasicLockable, for holding the lock across several
+// calls on inner().
+template<RawAllocator A, typename Mutex = std::mutex>
+class LockedAllocator {
+    [[no_unique_address]] A inner_alloc;
+    mutable Mutex mutex;
+
+public:
+    [[nodiscard]] void* allocate_bytes(size_t size) {
+        std::lock_guard<Mutex> guard(mutex);
+        return inner_alloc.allocate_bytes(size);
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) {
+        std::lock_guard<Mutex> guard(mutex);
+        inner_alloc.deallocate_bytes(ptr, size);
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const requires OwningAllocator<A> {
+        std::lock_guard<Mutex> guard(mutex);
+        return inner_alloc.owns(ptr);
+    }
+
+    void lock() { mutex.lock(); }
+    void unlock() { mutex.unlock(); }
+
+    // The wrapped allocator; hold the lock while using it once threads are running
+    A& inner() noexcept { return inner_alloc; }
+};
+
+// Memory Category Class
+// Attributes memory to a subsystem (rendering, audio, ...) with live and
+// peak byte counters and an optional budget. When a charge would exceed the
+// budget the over-budget callback decides: it may free memory elsewhere and
+// return true to let the charge through, or return false to fail the
+// allocation. Counters and the budget are atomic, so allocators on several
+// threads may share a category; install the callback before sharing it.
+class MemoryCategory {
+public:
+    // Called when a charge of `size` bytes would exceed the budget; the charge
+    // is already included in live_bytes() while the callback runs
+    using BudgetCallback = bool (*)(MemoryCategory& category, size_t size, void* context);
+
+private:
+    const char* category_name;
+    std::atomic<size_t> live{0};
+    std::atomic<size_t> peak{0};
+    std::atomic<size_t> denied{0};
+    std::atomic<size_t> limit;
+    BudgetCallback callback = nullptr;
+    void* callback_context = nullptr;
+
+public:
+    explicit MemoryCategory(const char* name, size_t budget = SIZE_MAX) noexcept
+        : category_name(name), limit(budget) {}
+
+    MemoryCategory(const MemoryCategory&) = delete;
+    MemoryCategory& operator=(const MemoryCategory&) = delete;
+
+    void set_budget(size_t budget) noexcept { limit.store(budget, std::memory_order_relaxed); }
+
+    // Not synchronized with charge(); call before other threads use the category
+    void set_budget_callback(BudgetCallback fn, void* context = nullptr) noexcept {
+        callback = fn;
+        callback_context = context;
+    }
+
+    // Account for `size` more bytes; false if over budget and the callback refused
+    [[nodiscard]] bool charge(size_t size) noexcept {
+        size_t before = live.load(std::memory_order_relaxed);
+        do {
+            if (size > SIZE_MAX - before) {
+                denied.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!live.compare_exchange_weak(before, before + size, std::memory_order_relaxed));
+        size_t budget_now = limit.load(std::memory_order_relaxed);
+        if ((before > budget_now || size > budget_now - before) &&
+            !(callback && callback(*this, size, callback_context))) {
+            live.fetch_sub(size, std::memory_order_relaxed);
+            denied.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        size_t now = before + size;
+        size_t high = peak.load(std::memory_order_relaxed);
+        while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed)) {
+        }
+        return true;
+    }
+
+    void release(size_t size) noexcept {
+        live.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] const char* name() const noexcept { return category_name; }
+    [[nodiscard]] size_t budget() const noexcept { return limit.load(std::memory_order_relaxed); }
+    [[nodiscard]] size_t live_bytes() const noexcept { return live.load(std::memory_order_relaxed); }
+    [[nodiscard]] size_t peak_bytes() const noexcept { return peak.load(std::memory_order_relaxed); }
+
+    // Charges refused because of the budget
+    [[nodiscard]] size_t denied_count() const noexcept { return denied.load(std::memory_order_relaxed); }
+};
+
+// Categorized Allocator Template Class
+// Charges every allocation made through A to a MemoryCategory. By default the
+// category belongs to the instance, which costs nothing per allocation; as the
+// Upstream of a BlockAllocator or FixedSizePool it charges their blocks. With
+// per_allocation = true each allocation records its category in a
+// max_align_t-sized prefix (see AffixAllocator), so one allocator can serve
+// several subsystems.
+template<RawAllocator A, bool per_allocation = false>
+class CategorizedAllocator {
+    using Inner = std::conditional_t<per_allocation, AffixAllocator<A, MemoryCategory*>, A>;
+
+    [[no_unique_address]] Inner inner_alloc;
+    MemoryCategory* category;
+    size_t charged = 0; // Bytes charged through this instance and not yet released
+
+public:
+    explicit CategorizedAllocator(MemoryCategory& default_category) noexcept : category(&default_category) {}
+
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept(noexcept(inner_alloc.allocate_bytes(size))) {
+        return allocate_bytes(size, *category);
+    }
+
+    // Allocate on behalf of `target`; the instance's own category unless per_allocation
+    [[nodiscard]] void* allocate_bytes(size_t size, MemoryCategory& target)
+        noexcept(noexcept(inner_alloc.allocate_bytes(size))) {
+        MemoryCategory& charged_category = per_allocation ? target : *category;
+        if (!charged_category.charge(size)) {
+            return nullptr;
+        }
+        void* ptr = inner_alloc.allocate_bytes(size);
+        if (!ptr) {
+            charged_category.release(size);
+            return nullptr;
+        }
+        if constexpr (per_allocation) {
+            Inner::prefix(ptr) = &charged_category;
+        }
+        charged += size;
+        return ptr;
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept(noexcept(inner_alloc.deallocate_bytes(ptr, size))) {
+        category_of(ptr).release(size);
+        charged -= size;
+        inner_alloc.deallocate_bytes(ptr, size);
+    }
+
+    // Reset the wrapped arena and release everything charged through this instance
+    void reset() noexcept requires (!per_allocation) && requires(A& a) { a.reset(); } {
+        inner_alloc.reset();
+        category->release(charged);
+        charged = 0;
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept(noexcept(inner_alloc.owns(ptr))) requires OwningAllocator<A> {
+        return inner_alloc.owns(ptr);
+    }
+
+    // Category an allocation was charged to
+    [[nodiscard]] MemoryCategory& category_of(void* ptr) const noexcept {
+        if constexpr (per_allocation) {
+            return *Inner::prefix(ptr);
+        } else {
+            (void)ptr;
+            return *category;
+        }
+    }
+
+    A& inner() noexcept {
+        if constexpr (per_allocation) {
+            return inner_alloc.inner();
+        } else {
+            return inner_alloc;
+        }
+    }
+};
+
+// Cycle Clock Class
+// Cheap timestamps for latency measurement: the TSC on x86, the steady clock
+// elsewhere. Tick rates are calibrated once against the steady clock.
+class CycleClock {
+public:
+    [[nodiscard]] static uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+        return __rdtsc();
+#else
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // Ticks per nanosecond, measured over a few milliseconds on first use
+    [[nodiscard]] static double ticks_per_nanosecond() noexcept {
+        static const double rate = [] {
+            auto start_time = std::chrono::steady_clock::now();
+            uint64_t start = now();
+            while (std::chrono::steady_clock::now() - start_time < std::chrono::milliseconds(10)) {
+            }
+            uint64_t ticks = now() - start;
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_time).count();
+            return elapsed > 0 ? double(ticks) / double(elapsed) : 1.0;
+        }();
+        return rate;
+    }
+
+    [[nodiscard]] static double to_nanoseconds(uint64_t ticks) noexcept {
+        return double(ticks) / ticks_per_nanosecond();
+    }
+};
+
+// Latency Histogram Class
+// Log-linear histogram: each power of two is split into 16 linear buckets, so
+// any recorded value is reported within about 6%. Histograms from different
+// threads are combined with merge().
+class LatencyHistogram {
+    static constexpr size_t sub_bucket_bits = 4;
+    static constexpr size_t sub_buckets = size_t(1) << sub_bucket_bits;
+    static constexpr size_t bucket_count = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+    std::array<uint64_t, bucket_count> counts{};
+    uint64_t total = 0;
+    uint64_t max_value = 0;
+
+    static size_t index_of(uint64_t value) noexcept {
+        if (value < sub_buckets) {
+            return size_t(value);
+        }
+        size_t shift = size_t(std::bit_width(value)) - 1 - sub_bucket_bits;
+        return (shift + 1) * sub_buckets + size_t((value >> shift) - sub_buckets);
+    }
+
+    // Largest value that falls into a bucket
+    static uint64_t upper_bound_of(size_t index) noexcept {
+        if (index < sub_buckets) {
+            return index;
+        }
+        size_t shift = index / sub_buckets - 1;
+        uint64_t lower = uint64_t(sub_buckets + index % sub_buckets) << shift;
+        return lower + ((uint64_t(1) << shift) - 1);
+    }
+
+public:
+    void record(uint64_t value) noexcept {
+        ++counts[index_of(value)];
+        ++total;
+        max_value = std::max(max_value, value);
+    }
+
+    void merge(const LatencyHistogram& other) noexcept {
+        for (size_t i = 0; i < bucket_count; ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        max_value = std::max(max_value, other.max_value);
+    }
+
+    void clear() noexcept {
+        counts.fill(0);
+        total = 0;
+        max_value = 0;
+    }
+
+    // Value at or below which a fraction p (0..1) of the samples fall, in recorded units
+    [[nodiscard]] uint64_t percentile(double p) const noexcept {
+        if (total == 0) {
+            return 0;
+        }
+        auto rank = uint64_t(p * double(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(upper_bound_of(i), max_value);
+            }
+        }
+        return max_value;
+    }
+
+    [[nodiscard]] uint64_t count() const noexcept { return total; }
+    [[nodiscard]] uint64_t max() const noexcept { return max_value; }
+};
+
+// Timed Allocator Template Class
+// Forwards to A and records the latency of every allocate_bytes and
+// deallocate_bytes call, in CycleClock ticks. Keep one per thread, like the
+// allocator it wraps, and merge the histograms for reporting.
+template<RawAllocator A>
+class TimedAllocator {
+    [[no_unique_address]] A inner_alloc;
+    LatencyHistogram allocate_latency;
+    LatencyHistogram free_latency;
+
+public:
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept(noexcept(inner_alloc.allocate_bytes(size))) {
+        uint64_t start = CycleClock::now();
+        void* ptr = inner_alloc.allocate_bytes(size);
+        allocate_latency.record(CycleClock::now() - start);
+        return ptr;
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept(noexcept(inner_alloc.deallocate_bytes(ptr, size))) {
+        uint64_t start = CycleClock::now();
+        inner_alloc.deallocate_bytes(ptr, size);
+        free_latency.record(CycleClock::now() - start);
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept(noexcept(inner_alloc.owns(ptr))) requires OwningAllocator<A> {
+        return inner_alloc.owns(ptr);
+    }
+
+    [[nodiscard]] const LatencyHistogram& allocate_histogram() const noexcept { return allocate_latency; }
+    [[nodiscard]] const LatencyHistogram& free_histogram() const noexcept { return free_latency; }
+    A& inner() noexcept { return inner_alloc; }
+};
+
+// Define ALLOCATOR_PROFILE_BACKTRACE (glibc/BSD) to capture call stacks for sampled allocations
+
+// Heap Profiler Class
+// Samples allocations on average once every `sample_interval` bytes: the gap
+// to the next sample is drawn from an exponential distribution, so every byte
+// is equally likely to be sampled no matter how requests are sized. Each
+// sampled allocation carries a weight (its expected share of the unsampled
+// bytes it stands for) and the call site that made it, and stays in the live
+// profile until it is freed. Not synchronized; use one per thread.
+class HeapProfiler {
+public:
+    static constexpr size_t max_frames = 32;
+
+    // Where a sampled allocation came from
+    struct Site {
+        std::source_location location;
+#if defined(ALLOCATOR_PROFILE_BACKTRACE)
+        void* frames[max_frames];
+        int depth = 0;
+#endif
+    };
+
+private:
+    struct Sample {
+        size_t size;
+        double weight;   // Estimated bytes this sample represents
+        Site site;
+    };
+
+    double mean_interval;
+    double bytes_until_sample;
+    uint64_t rng_state;
+    std::unordered_map<const void*, Sample> live;
+
+    // Exponentially distributed gap, in bytes, to the next sample
+    double next_interval() noexcept {
+        rng_state ^= rng_state << 13;
+        rng_state ^= rng_state >> 7;
+        rng_state ^= rng_state << 17;
+        double uniform = double((rng_state >> 11) + 1) * 0x1.0p-53; // (0, 1]
+        return -std::log(uniform) * mean_interval;
+    }
+
+    static void append_frame(std::string& stack, const char* frame) {
+        if (!stack.empty()) {
+            stack += ';';
+        }
+        for (const char* c = frame; *c; ++c) {
+            stack += *c == ';' ? ':' : *c; // ';' separates frames in the folded format
+        }
+    }
+
+public:
+    explicit HeapProfiler(size_t sample_interval = size_t(512) << 10, uint64_t seed = 0x9E3779B97F4A7C15ull)
+        : mean_interval(double(sample_interval)), rng_state(seed | 1) {
+        bytes_until_sample = next_interval();
+    }
+
+    // Decide whether an allocation of `size` bytes is sampled; cheap when it is not
+    [[nodiscard]] bool should_sample(size_t size) noexcept {
+        if (double(size) < bytes_until_sample) {
+            bytes_until_sample -= double(size);
+            return false;
+        }
+        bytes_until_sample = next_interval();
+        return true;
+    }
+
+    // Add a sampled allocation to the live profile
+    void record(const void* ptr, size_t size, const Site& site) {
+        double probability = 1.0 - std::exp(-double(size) / mean_interval);
+        live[ptr] = {size, probability > 0 ? double(size) / probability : double(size), site};
+    }
+
+    // Drop an allocation from the live profile if it was sampled
+    void release(const void* ptr) noexcept {
+        if (!live.empty()) {
+            live.erase(ptr);
+        }
+    }
+
+    // Estimated live bytes across all sampled call sites
+    [[nodiscard]] double estimated_live_bytes() const noexcept {
+        double bytes = 0;
+        for (const auto& entry : live) {
+            bytes += entry.second.weight;
+        }
+        return bytes;
+    }
+
+    // Write the live profile as folded stacks ("root;...;leaf bytes" per line),
+    // the input format of flamegraph.pl, speedscope and similar viewers
+    void dump_folded(std::FILE* out) const {
+        std::unordered_map<std::string, double> stacks;
+        for (const auto& entry : live) {
+            const Sample& sample = entry.second;
+            std::string stack;
+#if defined(ALLOCATOR_PROFILE_BACKTRACE)
+            if (char** symbols = backtrace_symbols(sample.site.frames, sample.site.depth)) {
+                for (int i = sample.site.depth; i-- > 0;) {
+                    append_frame(stack, symbols[i]);
+                }
+                std::free(symbols);
+            }
+#endif
+            char leaf[512];
+            std::snprintf(leaf, sizeof(leaf), "%s (%s:%u)", sample.site.location.function_name(),
+                          sample.site.location.file_name(), unsigned(sample.site.location.line()));
+            append_frame(stack, leaf);
+            stacks[stack] += sample.weight;
+        }
+        for (const auto& [stack, bytes] : stacks) {
+            std::fprintf(out, "%s %.0f\n", stack.c_str(), bytes);
+        }
+    }
+};
+
+// Profiled Allocator Template Class
+// Forwards to A and reports sampled allocations, with the caller's source
+// location, to a HeapProfiler. Use it as the outermost layer so the captured
+// location is the code that asked for memory.
+template<RawAllocator A>
+class ProfiledAllocator {
+    [[no_unique_address]] A inner_alloc;
+    HeapProfiler* profiler;
+
+public:
+    explicit ProfiledAllocator(HeapProfiler& heap_profiler) noexcept : profiler(&heap_profiler) {}
+
+    [[nodiscard]] void* allocate_bytes(size_t size,
+                                       std::source_location location = std::source_location::current()) {
+        void* ptr = inner_alloc.allocate_bytes(size);
+        if (ptr && profiler->should_sample(size)) {
+            HeapProfiler::Site site{};
+            site.location = location;
+#if defined(ALLOCATOR_PROFILE_BACKTRACE)
+            site.depth = backtrace(site.frames, int(HeapProfiler::max_frames));
+#endif
+            profiler->record(ptr, size, site);
+        }
+        return ptr;
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) noexcept(noexcept(profiler->release(ptr)) &&
+                                                           noexcept(inner_alloc.deallocate_bytes(ptr, size))) {
+        profiler->release(ptr);
+        inner_alloc.deallocate_bytes(ptr, size);
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept(noexcept(inner_alloc.owns(ptr))) requires OwningAllocator<A> {
+        return inner_alloc.owns(ptr);
+    }
+
+    A& inner() noexcept { return inner_alloc; }
+};
+
+// Allocation trace events
+enum class TraceOp : uint8_t {
+    Allocate = 1,    // id, size
+    Free = 2,        // id
+    Reallocate = 3,  // id, new size; the allocation keeps its id
+    Reset = 4,       // Every live allocation is released at once (arena reset)
+};
+
+struct TraceEvent {
+    TraceOp op;
+    uint64_t id = 0;    // Allocations are numbered from 0 in the order they were made
+    uint64_t size = 0;
+};
+
+// Trace Writer Class
+// Writes allocation events in a compact binary format: an 8-byte header
+// ("CMAT" and a version), then per event an op byte followed by LEB128
+// varints, so typical events take 3 to 6 bytes. Pointers are replaced by
+// allocation ids so traces do not depend on addresses. Not synchronized.
+class TraceWriter {
+public:
+    static constexpr uint32_t magic = 0x54414D43; // "CMAT" read as little-endian
+    static constexpr uint32_t version = 1;
+
+private:
+    std::FILE* out = nullptr;
+    std::vector<uint8_t> buffer;
+    std::unordered_map<const void*, uint64_t> ids;
+    uint64_t next_id = 0;
+
+    void put_varint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer.push_back(uint8_t(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back(uint8_t(value));
+    }
+
+    void put(TraceOp op, uint64_t id, uint64_t size, bool with_size) {
+        buffer.push_back(uint8_t(op));
+        if (op != TraceOp::Reset) {
+            put_varint(id);
+        }
+        if (with_size) {
+            put_varint(size);
+        }
+        if (buffer.size() >= (size_t(64) << 10)) {
+            flush();
+        }
+    }
+
+public:
+    // Write to `file`, which the caller keeps open until the writer is destroyed
+    explicit TraceWriter(std::FILE* file) : out(file) {
+        uint32_t header[2] = {magic, version};
+        std::fwrite(header, sizeof(header), 1, out);
+    }
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    ~TraceWriter() {
+        flush();
+    }
+
+    void on_allocate(const void* ptr, size_t size) {
+        uint64_t id = next_id++;
+        ids[ptr] = id;
+        put(TraceOp::Allocate, id, size, true);
+    }
+
+    void on_free(const void* ptr) {
+        auto it = ids.find(ptr);
+        if (it == ids.end()) {
+            return; // Allocated before tracing started
+        }
+        put(TraceOp::Free, it->second, 0, false);
+        ids.erase(it);
+    }
+
+    void on_reallocate(const void* old_ptr, const void* new_ptr, size_t size) {
+        auto it = ids.find(old_ptr);
+        if (it == ids.end()) {
+            on_allocate(new_ptr, size);
+            return;
+        }
+        uint64_t id = it->second;
+        ids.erase(it);
+        ids[new_ptr] = id;
+        put(TraceOp::Reallocate, id, size, true);
+    }
+
+    void on_reset() {
+        ids.clear();
+        put(TraceOp::Reset, 0, 0, false);
+    }
+
+    void flush() {
+        if (!buffer.empty()) {
+            std::fwrite(buffer.data(), 1, buffer.size(), out);
+            buffer.clear();
+        }
+        std::fflush(out);
+    }
+};
+
+// Trace Reader Class
+// Reads a whole trace written by TraceWriter into memory.
+class TraceReader {
+    std::vector<uint8_t> bytes;
+    size_t position = 0;
+    bool valid = false;
+
+    bool get_varint(uint64_t& value) noexcept {
+        value = 0;
+        for (unsigned shift = 0; position < bytes.size() && shift < 64; shift += 7) {
+            uint8_t byte = bytes[position++];
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    explicit TraceReader(std::FILE* in) {
+        uint8_t chunk[1 << 16];
+        size_t read;
+        while ((read = std::fread(chunk, 1, sizeof(chunk), in)) > 0) {
+            bytes.insert(bytes.end(), chunk, chunk + read);
+        }
+        uint32_t header[2] = {};
+        if (bytes.size() >= sizeof(header)) {
+            std::memcpy(header, bytes.data(), sizeof(header));
+            position = sizeof(header);
+        }
+        valid = header[0] == TraceWriter::magic && header[1] == TraceWriter::version;
+    }
+
+    // Whether the input started with a trace header this reader understands
+    [[nodiscard]] bool ok() const noexcept { return valid; }
+
+    // Decode the next event; false at the end of the trace or on a truncated event
+    bool next(TraceEvent& event) noexcept {
+        if (!valid || position >= bytes.size()) {
+            return false;
+        }
+        event.op = TraceOp(bytes[position++]);
+        event.id = 0;
+        event.size = 0;
+        switch (event.op) {
+        case TraceOp::Allocate:
+        case TraceOp::Reallocate:
+            return get_varint(event.id) && get_varint(event.size);
+        case TraceOp::Free:
+            return get_varint(event.id);
+        case TraceOp::Reset:
+            return true;
+        }
+        return false; // Unknown op
+    }
+};
+
+// Tracing Allocator Template Class
+// Forwards to A and writes every allocation, free and reset to a TraceWriter.
+template<RawAllocator A>
+class TracingAllocator {
+    [[no_unique_address]] A inner_alloc;
+    TraceWriter* writer;
+
+public:
+    explicit TracingAllocator(TraceWriter& trace_writer) noexcept : writer(&trace_writer) {}
+
+    [[nodiscard]] void* allocate_bytes(size_t size) {
+        void* ptr = inner_alloc.allocate_bytes(size);
+        if (ptr) {
+            writer->on_allocate(ptr, size);
+        }
+        return ptr;
+    }
+
+    void deallocate_bytes(void* ptr, size_t size) {
+        writer->on_free(ptr);
+        inner_alloc.deallocate_bytes(ptr, size);
+    }
+
+    // Reset the wrapped arena and record it
+    void reset() requires requires(A& a) { a.reset(); } {
+        inner_alloc.reset();
+        writer->on_reset();
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept(noexcept(inner_alloc.owns(ptr))) requires OwningAllocator<A> {
+        return inner_alloc.owns(ptr);
+    }
+
+    A& inner() noexcept { return inner_alloc; }
+};
+
+// Handle to an object in a HandlePool; stays valid while the object moves
+struct Handle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    friend bool operator==(const Handle&, const Handle&) = default;
+};
+
+// Handle Pool Template Class
+// Pool addressed through generation-checked handles instead of raw pointers,
+// which lets compact() relocate objects: live objects are moved out of the
+// sparsest blocks into the densest ones in bounded steps, and blocks that
+// empty out are returned upstream.
+template<Constructible T, size_t block_size = 256, RawAllocator Upstream = DefaultUpstream>
+class HandlePool {
+    static constexpr size_t block_bytes = sizeof(T) * block_size;
+    static constexpr uint32_t no_owner = UINT32_MAX;
+
+    struct Block {
+        uint8_t* mem = nullptr;            // nullptr once released
+        size_t live = 0;
+        bool open = false;                 // Listed in open_blocks
+        std::vector<uint32_t> owners;      // Handle index per slot, no_owner when free
+        std::vector<uint32_t> free_slots;
+    };
+
+    struct Entry {
+        uint32_t block = 0;
+        uint32_t slot = 0;
+        uint32_t generation = 0;
+        bool live = false;
+    };
+
+    std::vector<Block> blocks;
+    std::vector<uint32_t> open_blocks;     // Blocks that may have free slots (checked lazily)
+    std::vector<uint32_t> released;        // Block records without memory
+    std::vector<Entry> entries;            // Handle table
+    std::vector<uint32_t> free_entries;
+    size_t live_count = 0;
+    Upstream upstream;
+
+    T* slot_ptr(uint32_t block, uint32_t slot) const noexcept {
+        return reinterpret_cast<T*>(blocks[block].mem) + slot;
+    }
+
+    void open(uint32_t index) {
+        if (!blocks[index].open) {
+            blocks[index].open = true;
+            open_blocks.push_back(index);
+        }
+    }
+
+    uint32_t new_block() {
+        EventScope<> event("block", this, block_bytes);
+        // Everything that can throw happens before the memory is taken, so it cannot leak
+        Block fresh;
+        fresh.owners.assign(block_size, no_owner);
+        fresh.free_slots.resize(block_size);
+        for (size_t i = 0; i < block_size; ++i) {
+            fresh.free_slots[i] = uint32_t(block_size - 1 - i); // Fill from slot 0 upwards
+        }
+        if (released.empty() && blocks.size() == blocks.capacity()) {
+            blocks.reserve(blocks.size() * 2 + 1);
+        }
+        fresh.mem = static_cast<uint8_t*>(upstream.allocate_bytes(block_bytes));
+        if (!fresh.mem) {
+            throw std::bad_alloc();
+        }
+        uint32_t index;
+        if (!released.empty()) {
+            index = released.back();
+            released.pop_back();
+            blocks[index] = std::move(fresh);
+        } else {
+            index = uint32_t(blocks.size());
+            blocks.push_back(std::move(fresh));
+        }
+        return index;
+    }
+
+    void release_block(uint32_t index) noexcept {
+        Block& block = blocks[index];
+        upstream.deallocate_bytes(block.mem, block_bytes);
+        block.mem = nullptr;
+        block.owners.clear();
+        block.free_slots.clear();
+        released.push_back(index);
+    }
+
+    // Move one object from `from` to a free slot of `to` and repoint its handle
+    void relocate(uint32_t from, uint32_t slot, uint32_t to) {
+        Block& dst = blocks[to];
+        uint32_t dst_slot = dst.free_slots.back();
+        dst.free_slots.pop_back();
+        T* src_ptr = slot_ptr(from, slot);
+        T* dst_ptr = slot_ptr(to, dst_slot);
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            std::memcpy(static_cast<void*>(dst_ptr), static_cast<const void*>(src_ptr), sizeof(T));
+        } else {
+            new (dst_ptr) T(std::move(*src_ptr));
+            src_ptr->~T();
+        }
+        uint32_t owner = blocks[from].owners[slot];
+        dst.owners[dst_slot] = owner;
+        ++dst.live;
+        entries[owner].block = to;
+        entries[owner].slot = dst_slot;
+
+        Block& src = blocks[from];
+        src.owners[slot] = no_owner;
+        src.free_slots.push_back(slot);
+        --src.live;
+    }
+
+    // Sparsest non-empty block and the densest other non-full block; false if compaction cannot help
+    bool pick_pair(uint32_t& source, uint32_t& target) const noexcept {
+        auto partial = [&](const Block& block) {
+            return block.mem && block.live != 0 && block.live != block_size;
+        };
+        bool have_source = false;
+        for (uint32_t i = 0; i < blocks.size(); ++i) {
+            if (partial(blocks[i]) && (!have_source || blocks[i].live < blocks[source].live)) {
+                source = i;
+                have_source = true;
+            }
+        }
+        if (!have_source) {
+            return false;
+        }
+        bool have_target = false;
+        for (uint32_t i = 0; i < blocks.size(); ++i) {
+            if (i != source && partial(blocks[i]) && (!have_target || blocks[i].live > blocks[target].live)) {
+                target = i;
+                have_target = true;
+            }
+        }
+        return have_target;
+    }
+
+public:
+    HandlePool() = default;
+
+    // Take block memory from the given upstream
+    explicit HandlePool(Upstream source) : upstream(std::move(source)) {}
+
+    HandlePool(const HandlePool&) = delete;
+    HandlePool& operator=(const HandlePool&) = delete;
+
+    // Construct an object and return its handle
+    template<typename... Args>
+    [[nodiscard]] Handle allocate(Args&&... args) {
+        while (!open_blocks.empty()) {
+            Block& block = blocks[open_blocks.back()];
+            if (block.mem && !block.free_slots.empty()) {
+                break;
+            }
+            block.open = false;
+            open_blocks.pop_back();
+        }
+        if (open_blocks.empty()) {
+            open(new_block());
+        }
+        uint32_t index = open_blocks.back();
+        Block& block = blocks[index];
+        uint32_t slot = block.free_slots.back();
+        new (slot_ptr(index, slot)) T(std::forward<Args>(args)...); // Construct in-place
+        block.free_slots.pop_back();
+
+        uint32_t entry;
+        if (!free_entries.empty()) {
+            entry = free_entries.back();
+            free_entries.pop_back();
+        } else {
+            entry = uint32_t(entries.size());
+            entries.emplace_back();
+        }
+        entries[entry].block = index;
+        entries[entry].slot = slot;
+        entries[entry].live = true;
+        block.owners[slot] = entry;
+        ++block.live;
+        ++live_count;
+        return {entry, entries[entry].generation};
+    }
+
+    // Destroy the object behind a handle; stale handles are ignored
+    void free(Handle handle) {
+        if (!get(handle)) {
+            return;
+        }
+        Entry& entry = entries[handle.index];
+        Block& block = blocks[entry.block];
+        slot_ptr(entry.block, entry.slot)->~T();
+        block.owners[entry.slot] = no_owner;
+        block.free_slots.push_back(entry.slot);
+        --block.live;
+        open(entry.block);
+        entry.live = false;
+        ++entry.generation;
+        free_entries.push_back(handle.index);
+        --live_count;
+    }
+
+    // Resolve a handle; nullptr if it is stale. Pointers are invalidated by compact()
+    [[nodiscard]] T* get(Handle handle) const noexcept {
+        if (handle.index >= entries.size()) {
+            return nullptr;
+        }
+        const Entry& entry = entries[handle.index];
+        if (!entry.live || entry.generation != handle.generation) {
+            return nullptr;
+        }
+        return slot_ptr(entry.block, entry.slot);
+    }
+
+    // Relocate up to max_moves objects from sparse blocks into dense ones and
+    // release blocks that become empty. Returns the number of objects moved.
+    size_t compact(size_t max_moves) {
+        size_t moved = 0;
+        uint32_t source = 0;
+        uint32_t target = 0;
+        while (moved < max_moves && pick_pair(source, target)) {
+            Block& src = blocks[source];
+            for (uint32_t slot = 0; slot < block_size && moved < max_moves; ++slot) {
+                if (src.owners[slot] == no_owner) {
+                    continue;
+                }
+                if (blocks[target].free_slots.empty()) {
+                    break;
+                }
+                relocate(source, slot, target);
+                ++moved;
+            }
+            if (src.live == 0) {
+                release_block(source);
+            }
+        }
+        return moved;
+    }
+
+    // Run compact() in small steps until no work is left or the time slice is used up
+    size_t compact(std::chrono::nanoseconds budget) {
+        auto deadline = std::chrono::steady_clock::now() + budget;
+        size_t moved = 0;
+        while (std::chrono::steady_clock::now() < deadline) {
+            size_t step = compact(size_t(32));
+            moved += step;
+            if (step == 0) {
+                break;
+            }
+        }
+        return moved;
+    }
+
+    // Return every empty block to the upstream
+    void trim() noexcept {
+        EventScope<> event("trim", this);
+        size_t released_bytes = 0;
+        for (uint32_t i = 0; i < blocks.size(); ++i) {
+            if (blocks[i].mem && blocks[i].live == 0) {
+                release_block(i);
+                released_bytes += block_bytes;
+            }
+        }
+        event.set_bytes(released_bytes);
+    }
+
+    // Visit every live object, block by block
+    template<typename F>
+    void for_each(F&& f) {
+        for (uint32_t i = 0; i < blocks.size(); ++i) {
+            const Block& block = blocks[i];
+            if (!block.mem) {
+                continue;
+            }
+            for (uint32_t slot = 0; slot < block_size; ++slot) {
+                if (block.owners[slot] != no_owner) {
+                    f(*slot_ptr(i, slot));
+                }
+            }
+        }
+    }
+
+    // Number of live objects
+    [[nodiscard]] size_t size() const noexcept {
+        return live_count;
+    }
+
+    // Number of blocks holding memory
+    [[nodiscard]] size_t block_count() const noexcept {
+        return blocks.size() - released.size();
+    }
+
+    // Destructor to destroy live objects and return all blocks
+    ~HandlePool() {
+        for (uint32_t i = 0; i < blocks.size(); ++i) {
+            if (!blocks[i].mem) {
+                continue;
+            }
+            for (uint32_t slot = 0; slot < block_size; ++slot) {
+                if (blocks[i].owners[slot] != no_owner) {
+                    slot_ptr(i, slot)->~T();
+                }
+            }
+            upstream.deallocate_bytes(blocks[i].mem, block_bytes);
+        }
+    }
+};
+
+// Hive Template Class
+// Unordered container with stable element addresses, in the spirit of
+// std::hive. Elements live in BlockAllocator-style blocks; erased slots form
+// runs recorded in a jump-counting skipfield (the first and last slot of each
+// run hold its length), so iteration skips a whole run in one step. Erase is
+// O(1), inserts reuse erased slots first, and empty blocks are returned.
+template<Constructible T, size_t block_size = 256, RawAllocator Upstream = DefaultUpstream>
+class Hive {
+    static_assert(block_size > 0 && block_size < UINT16_MAX, "skipfield entries are 16-bit");
+
+    static constexpr uint16_t no_run = UINT16_MAX;
+
+    // Links of the per-block list of erased runs, kept in a run's first slot
+    struct FreeRun {
+        uint16_t prev;
+        uint16_t next;
+    };
+
+    struct alignas(alignof(T) > alignof(FreeRun) ? alignof(T) : alignof(FreeRun)) Slot {
+        unsigned char bytes[sizeof(T) > sizeof(FreeRun) ? sizeof(T) : sizeof(FreeRun)];
+    };
+
+    struct Block {
+        Slot* slots;
+        uint16_t* skip;                   // block_size entries plus a zero sentinel
+        Block* next = nullptr;            // Iteration order
+        Block* prev = nullptr;
+        Block* next_open = nullptr;       // Blocks with erased slots
+        Block* prev_open = nullptr;
+        size_t size = 0;
+        uint16_t free_head = no_run;      // First erased run
+        bool open = false;
+    };
+
+    // Header, slots and skipfield share one upstream allocation
+    static constexpr size_t slots_offset = (sizeof(Block) + alignof(Slot) - 1) & ~(alignof(Slot) - 1);
+    static constexpr size_t skip_offset = slots_offset + sizeof(Slot) * block_size;
+    static constexpr size_t block_bytes = skip_offset + sizeof(uint16_t) * (block_size + 1);
+
+    Block* first = nullptr;
+    Block* last = nullptr;
+    Block* open_blocks = nullptr;
+    size_t total = 0;
+    Upstream upstream;
+
+    static T* value(Block* block, size_t index) noexcept {
+        return std::launder(reinterpret_cast<T*>(block->slots[index].bytes));
+    }
+
+    static FreeRun* run(Block* block, size_t index) noexcept {
+        return reinterpret_cast<FreeRun*>(block->slots[index].bytes);
+    }
+
+    Block* new_block() {
+        EventScope<> event("block", this, block_bytes);
+        auto* mem = static_cast<uint8_t*>(upstream.allocate_bytes(block_bytes));
+        if (!mem) {
+            throw std::bad_alloc();
+        }
+        Block* block = new (mem) Block();
+        block->slots = reinterpret_cast<Slot*>(mem + slots_offset);
+        block->skip = reinterpret_cast<uint16_t*>(mem + skip_offset);
+
+        // The whole block starts as one erased run; interior slots only need to be non-zero
+        std::fill_n(block->skip, block_size, uint16_t(1));
+        block->skip[0] = uint16_t(block_size);
+        block->skip[block_size - 1] = uint16_t(block_size);
+        block->skip[block_size] = 0;
+        *run(block, 0) = {no_run, no_run};
+        block->free_head = 0;
+
+        block->prev = last;
+        (last ? last->next : first) = block;
+        last = block;
+        set_open(block, true);
+        return block;
+    }
+
+    void delete_block(Block* block) noexcept {
+        set_open(block, false);
+        (block->prev ? block->prev->next : first) = block->next;
+        (block->next ? block->next->prev : last) = block->prev;
+        upstream.deallocate_bytes(block, block_bytes);
+    }
+
+    void set_open(Block* block, bool open) noexcept {
+        if (block->open == open) {
+            return;
+        }
+        block->open = open;
+        if (open) {
+            block->prev_open = nullptr;
+            block->next_open = open_blocks;
+            if (open_blocks) {
+                open_blocks->prev_open = block;
+            }
+            open_blocks = block;
+        } else {
+            (block->prev_open ? block->prev_open->next_open : open_blocks) = block->next_open;
+            if (block->next_open) {
+                block->next_open->prev_open = block->prev_open;
+            }
+        }
+    }
+
+    // Put `replacement` in the run list where `start` was (no_run removes it)
+    static void replace_run(Block* block, uint16_t start, uint16_t replacement) noexcept {
+        FreeRun links = *run(block, start);
+        if (replacement != no_run) {
+            *run(block, replacement) = links;
+        }
+        uint16_t linked = replacement != no_run ? replacement : links.next;
+        if (links.prev != no_run) {
+            run(block, links.prev)->next = linked;
+        } else {
+            block->free_head = linked;
+        }
+        if (links.next != no_run) {
+            run(block, links.next)->prev = replacement != no_run ? replacement : links.prev;
+        }
+    }
+
+    static void push_run(Block* block, uint16_t start) noexcept {
+        *run(block, start) = {no_run, block->free_head};
+        if (block->free_head != no_run) {
+            run(block, block->free_head)->prev = start;
+        }
+        block->free_head = start;
+    }
+
+public:
+    template<bool is_const>
+    class basic_iterator {
+        friend class Hive;
+
+        Block* block = nullptr;
+        size_t index = 0;
+
+        basic_iterator(Block* at, size_t slot) noexcept : block(at), index(slot) {}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<is_const, const T*, T*>;
+        using reference = std::conditional_t<is_const, const T&, T&>;
+
+        basic_iterator() = default;
+
+        // Allow iterator -> const_iterator
+        operator basic_iterator<true>() const noexcept { return {block, index}; }
+
+        reference operator*() const noexcept { return *value(block, index); }
+        pointer operator->() const noexcept { return value(block, index); }
+
+        basic_iterator& operator++() noexcept {
+            ++index;
+            index += block->skip[index];
+            if (index == block_size) {
+                block = block->next;
+                index = block ? block->skip[0] : 0;
+            }
+            return *this;
+        }
+
+        basic_iterator operator++(int) noexcept {
+            basic_iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept {
+            return a.block == b.block && a.index == b.index;
+        }
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    Hive() = default;
+
+    // Take block memory from the given upstream
+    explicit Hive(Upstream source) : upstream(std::move(source)) {}
+
+    Hive(const Hive&) = delete;
+    Hive& operator=(const Hive&) = delete;
+
+    ~Hive() {
+        clear();
+    }
+
+    // Construct an element, reusing an erased slot when there is one
+    template<typename... Args>
+    iterator emplace(Args&&... args) {
+        Block* block = open_blocks ? open_blocks : new_block();
+        uint16_t start = block->free_head;
+        uint16_t length = block->skip[start];
+        FreeRun links = *run(block, start);
+
+        try {
+            new (block->slots[start].bytes) T(std::forward<Args>(args)...); // Construct in-place
+        } catch (...) {
+            *run(block, start) = links;
+            if (block->size == 0) {
+                delete_block(block);
+            }
+            throw;
+        }
+
+        // Shrink the run from the front; the construction overwrote its links
+        if (length == 1) {
+            if (links.prev != no_run) {
+                run(block, links.prev)->next = links.next;
+            } else {
+                block->free_head = links.next;
+            }
+            if (links.next != no_run) {
+                run(block, links.next)->prev = links.prev;
+            }
+        } else {
+            uint16_t next_start = uint16_t(start + 1);
+            block->skip[next_start] = uint16_t(length - 1);
+            block->skip[start + length - 1] = uint16_t(length - 1);
+            *run(block, next_start) = links;
+            if (links.prev != no_run) {
+                run(block, links.prev)->next = next_start;
+            } else {
+                block->free_head = next_start;
+            }
+            if (links.next != no_run) {
+                run(block, links.next)->prev = next_start;
+            }
+        }
+        block->skip[start] = 0;
+        ++block->size;
+        ++total;
+        if (block->free_head == no_run) {
+            set_open(block, false);
+        }
+        return {block, start};
+    }
+
+    iterator insert(const T& element) {
+        return emplace(element);
+    }
+
+    iterator insert(T&& element) {
+        return emplace(std::move(element));
+    }
+
+    // Destroy an element; returns an iterator to the one after it
+    iterator erase(const_iterator position) {
+        Block* block = position.block;
+        size_t index = position.index;
+        iterator next{block, index};
+        ++next;
+
+        value(block, index)->~T();
+        --total;
+        if (--block->size == 0) {
+            delete_block(block);
+            return next;
+        }
+
+        bool left = index > 0 && block->skip[index - 1] != 0;
+        bool right = block->skip[index + 1] != 0; // The sentinel keeps this in bounds
+        auto slot = uint16_t(index);
+        if (!left && !right) {
+            block->skip[index] = 1;
+            push_run(block, slot);
+        } else if (left && !right) {
+            uint16_t length = uint16_t(block->skip[index - 1] + 1);
+            block->skip[index - length + 1] = length;
+            block->skip[index] = length;
+        } else if (!left && right) {
+            uint16_t right_length = block->skip[index + 1];
+            block->skip[index] = uint16_t(right_length + 1);
+            block->skip[index + right_length] = uint16_t(right_length + 1);
+            replace_run(block, uint16_t(index + 1), slot);
+        } else {
+            uint16_t left_length = block->skip[index - 1];
+            uint16_t right_length = block->skip[index + 1];
+            uint16_t length = uint16_t(left_length + 1 + right_length);
+            block->skip[index - left_length] = length;
+            block->skip[index + right_length] = length;
+            block->skip[index] = 1; // Interior slots only need to be non-zero
+            replace_run(block, uint16_t(index + 1), no_run);
+        }
+        set_open(block, true);
+        return next;
+    }
+
+    // Iterator for an element of this hive, found by address; end() if not present
+    [[nodiscard]] iterator get_iterator(const T* element) const noexcept {
+        auto* address = reinterpret_cast<const unsigned char*>(element);
+        for (Block* block = first; block; block = block->next) {
+            auto* slots = reinterpret_cast<const unsigned char*>(block->slots);
+            if (address >= slots && address < slots + sizeof(Slot) * block_size) {
+                size_t offset = size_t(address - slots);
+                size_t index = offset / sizeof(Slot);
+                return offset % sizeof(Slot) == 0 && block->skip[index] == 0 ? iterator{block, index} : iterator{};
+            }
+        }
+        return {};
+    }
+
+    // Destroy every element and return all blocks
+    void clear() noexcept {
+        for (iterator it = begin(); it != end(); ++it) {
+            it->~T();
+        }
+        while (first) {
+            Block* next = first->next;
+            upstream.deallocate_bytes(first, block_bytes);
+            first = next;
+        }
+        last = nullptr;
+        open_blocks = nullptr;
+        total = 0;
+    }
+
+    iterator begin() noexcept { return first ? iterator{first, first->skip[0]} : iterator{}; }
+    iterator end() noexcept { return {}; }
+    const_iterator begin() const noexcept { return first ? const_iterator{first, first->skip[0]} : const_iterator{}; }
+    const_iterator end() const noexcept { return {}; }
+
+    [[nodiscard]] size_t size() const noexcept { return total; }
+    [[nodiscard]] bool empty() const noexcept { return total == 0; }
+};
+
+// Field list for SoAPool
+template<typename... Fields>
+struct FieldList {};
+
+// Structure-of-Arrays Pool Template Class
+// Stores each field of a record in its own cache-line aligned array per block,
+// so loops that touch one or two fields stream only those fields. Rows are
+// kept dense by swap-removal (the last row moves into an erased one); stable
+// access goes through Handles, and block_span<I>(b) exposes each block's
+// rows of field I as a contiguous span for vectorized loops.
+template<typename Fields, size_t block_size = 1024, RawAllocator Upstream = DefaultUpstream>
+class SoAPool;
+
+template<typename... Fields, size_t block_size, RawAllocator Upstream>
+class SoAPool<FieldList<Fields...>, block_size, Upstream> {
+public:
+    template<size_t I>
+    using field_type = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+private:
+    static constexpr size_t field_count = sizeof...(Fields);
+    static constexpr size_t column_alignment = 64;
+
+    static constexpr size_t align_column(size_t n) noexcept {
+        return (n + column_alignment - 1) & ~(column_alignment - 1);
+    }
+
+    // Offset of every column inside a block, each one starting on a cache line
+    static constexpr auto column_offsets = [] {
+        std::array<size_t, field_count + 1> offsets{};
+        size_t sizes[] = {sizeof(Fields)...};
+        for (size_t i = 0; i < field_count; ++i) {
+            offsets[i + 1] = align_column(offsets[i] + sizes[i] * block_size);
+        }
+        return offsets;
+    }();
+
+    // Extra bytes let each block be aligned by hand, whatever the upstream guarantees
+    static constexpr size_t block_bytes = column_offsets[field_count] + column_alignment;
+
+    struct Entry {
+        size_t row = 0;
+        uint32_t generation = 0;
+        bool live = false;
+    };
+
+    struct Block {
+        void* mem;      // As returned by the upstream
+        uint8_t* base;  // Aligned start of the first column
+    };
+
+    std::vector<Block> blocks;
+    std::vector<Entry> entries;             // Handle table
+    std::vector<uint32_t> free_entries;
+    std::vector<uint32_t> row_owner;        // Handle index of every row
+    size_t count = 0;
+    Upstream upstream;
+
+    template<size_t I>
+    field_type<I>* column(size_t block) const noexcept {
+        return reinterpret_cast<field_type<I>*>(blocks[block].base + column_offsets[I]);
+    }
+
+    template<size_t I>
+    field_type<I>& cell(size_t row) const noexcept {
+        return column<I>(row / block_size)[row % block_size];
+    }
+
+    void add_block() {
+        EventScope<> event("block", this, block_bytes);
+        blocks.reserve(blocks.size() + 1); // So the push_back below cannot throw and leak mem
+        void* mem = upstream.allocate_bytes(block_bytes);
+        if (!mem) {
+            throw std::bad_alloc();
+        }
+        auto address = reinterpret_cast<uintptr_t>(mem);
+        auto* base = reinterpret_cast<uint8_t*>((address + column_alignment - 1) & ~uintptr_t(column_alignment - 1));
+        blocks.push_back({mem, base});
+    }
+
+    // Release blocks beyond the one holding the last row, keeping one spare
+    void shrink() noexcept {
+        size_t needed = (count + block_size - 1) / block_size + 1;
+        while (blocks.size() > needed) {
+            upstream.deallocate_bytes(blocks.back().mem, block_bytes);
+            blocks.pop_back();
+        }
+    }
+
+    template<size_t... I>
+    void move_row(size_t from, size_t to, std::index_sequence<I...>) {
+        ((cell<I>(to) = std::move(cell<I>(from))), ...);
+    }
+
+    template<size_t... I>
+    void destroy_row(size_t row, std::index_sequence<I...>) noexcept {
+        (std::destroy_at(&cell<I>(row)), ...);
+    }
+
+    // Construct fields I onwards; if one throws, the fields before it are destroyed
+    template<size_t I, typename Arg, typename... Rest>
+    void construct_row(size_t row, Arg&& value, Rest&&... rest) {
+        std::construct_at(&cell<I>(row), std::forward<Arg>(value));
+        if constexpr (sizeof...(Rest) > 0) {
+            try {
+                construct_row<I + 1>(row, std::forward<Rest>(rest)...);
+            } catch (...) {
+                std::destroy_at(&cell<I>(row));
+                throw;
+            }
+        }
+    }
+
+public:
+    SoAPool() = default;
+
+    // Take block memory from the given upstream
+    explicit SoAPool(Upstream source) : upstream(std::move(source)) {}
+
+    SoAPool(const SoAPool&) = delete;
+    SoAPool& operator=(const SoAPool&) = delete;
+
+    ~SoAPool() {
+        for (size_t row = 0; row < count; ++row) {
+            destroy_row(row, std::index_sequence_for<Fields...>{});
+        }
+        for (const Block& block : blocks) {
+            upstream.deallocate_bytes(block.mem, block_bytes);
+        }
+    }
+
+    // Append a row and return its handle
+    template<typename... Args>
+    requires (sizeof...(Args) == sizeof...(Fields))
+    [[nodiscard]] Handle push(Args&&... values) {
+        if (count == blocks.size() * block_size) {
+            add_block();
+        }
+        uint32_t entry;
+        if (!free_entries.empty()) {
+            entry = free_entries.back();
+        } else {
+            entry = uint32_t(entries.size());
+            entries.emplace_back();
+        }
+        row_owner.resize(count + 1);
+        construct_row<0>(count, std::forward<Args>(values)...);
+        if (!free_entries.empty()) {
+            free_entries.pop_back();
+        }
+        entries[entry].row = count;
+        entries[entry].live = true;
+        row_owner[count] = entry;
+        ++count;
+        return {entry, entries[entry].generation};
+    }
+
+    // Remove a row by moving the last row into its place; stale handles are ignored
+    void erase(Handle handle) {
+        if (!contains(handle)) {
+            return;
+        }
+        Entry& entry = entries[handle.index];
+        size_t row = entry.row;
+        size_t last = count - 1;
+        if (row != last) {
+            move_row(last, row, std::index_sequence_for<Fields...>{});
+            row_owner[row] = row_owner[last];
+            entries[row_owner[row]].row = row;
+        }
+        destroy_row(last, std::index_sequence_for<Fields...>{});
+        entry.live = false;
+        ++entry.generation;
+        free_entries.push_back(handle.index);
+        --count;
+        row_owner.pop_back();
+        shrink();
+    }
+
+    // Whether a handle refers to a live row
+    [[nodiscard]] bool contains(Handle handle) const noexcept {
+        return handle.index < entries.size() && entries[handle.index].live &&
+               entries[handle.index].generation == handle.generation;
+    }
+
+    // Current row of a live handle; rows change when other rows are erased
+    [[nodiscard]] size_t row_of(Handle handle) const noexcept {
+        assert(contains(handle));
+        return entries[handle.index].row;
+    }
+
+    // Field I of a live handle
+    template<size_t I>
+    [[nodiscard]] field_type<I>& get(Handle handle) noexcept {
+        return cell<I>(row_of(handle));
+    }
+
+    // Field I of a row
+    template<size_t I>
+    [[nodiscard]] field_type<I>& at(size_t row) noexcept {
+        assert(row < count);
+        return cell<I>(row);
+    }
+
+    // The live rows of field I in block b
+    template<size_t I>
+    [[nodiscard]] std::span<field_type<I>> block_span(size_t b) noexcept {
+        size_t first = b * block_size;
+        size_t rows = count > first ? std::min(block_size, count - first) : 0;
+        return {column<I>(b), rows};
+    }
+
+    // Number of blocks that hold rows
+    [[nodiscard]] size_t block_count() const noexcept {
+        return (count + block_size - 1) / block_size;
+    }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return count;
+    }
+};
+
+// Chunk Allocator Template Class
+// Fixed-size, cache-line aligned chunks carved from larger upstream slabs.
+// Freed chunks go on an intrusive free list and are handed out again before
+// any new slab is requested, as BlockAllocator does with its slots.
+template<size_t chunk_bytes = 16384, size_t chunks_per_slab = 16, RawAllocator Upstream = DefaultUpstream>
+class ChunkAllocator {
+public:
+    static constexpr size_t chunk_size = chunk_bytes;
+    static constexpr size_t chunk_alignment = 64;
+
+private:
+    static_assert(chunk_bytes % chunk_alignment == 0, "chunk_bytes must be a multiple of 64");
+
+    static constexpr size_t slab_bytes = chunk_bytes * chunks_per_slab + chunk_alignment;
+
+    std::vector<void*> slabs;        // As returned by the upstream
+    void* free_head = nullptr;       // Next pointer stored in each free chunk
+    Upstream upstream;
+
+public:
+    ChunkAllocator() = default;
+
+    // Take slab memory from the given upstream
+    explicit ChunkAllocator(Upstream source) : upstream(std::move(source)) {}
+
+    ChunkAllocator(const ChunkAllocator&) = delete;
+    ChunkAllocator& operator=(const ChunkAllocator&) = delete;
+
+    ~ChunkAllocator() {
+        for (void* slab : slabs) {
+            upstream.deallocate_bytes(slab, slab_bytes);
+        }
+    }
+
+    // Allocate one chunk
+    [[nodiscard]] uint8_t* allocate() {
+        if (!free_head) {
+            EventScope<> event("block", this, slab_bytes);
+            slabs.reserve(slabs.size() + 1); // So the push_back below cannot throw and leak the slab
+            void* slab = upstream.allocate_bytes(slab_bytes);
+            if (!slab) {
+                throw std::bad_alloc();
+            }
+            slabs.push_back(slab);
+            auto address = reinterpret_cast<uintptr_t>(slab);
+            auto* first = reinterpret_cast<uint8_t*>((address + chunk_alignment - 1) & ~uintptr_t(chunk_alignment - 1));
+            for (size_t i = chunks_per_slab; i-- > 0;) {
+                free(first + i * chunk_bytes);
+            }
+        }
+        void* chunk = free_head;
+        free_head = *static_cast<void**>(chunk);
+        return static_cast<uint8_t*>(chunk);
+    }
+
+    // Return a chunk to the free list
+    void free(void* chunk) noexcept {
+        *static_cast<void**>(chunk) = free_head;
+        free_head = chunk;
+    }
+};
+
+// Size and alignment of one component type
+struct ComponentInfo {
+    size_t size;
+    size_t alignment;
+};
+
+template<typename T>
+constexpr ComponentInfo component_info() noexcept {
+    static_assert(std::is_trivially_copyable_v<T>, "chunk rows are moved with memcpy");
+    return {sizeof(T), alignof(T)};
+}
+
+// Location of an entity's row in an Archetype
+struct ChunkRow {
+    uint32_t chunk;
+    uint32_t row;
+};
+
+// Archetype Template Class
+// Entity storage for one set of component types chosen at runtime. Each chunk
+// holds a column per component plus a column of entity ids; rows are kept
+// packed by moving the archetype's last row into a removed one, so every
+// chunk but the last is full and empty chunks go back to the ChunkAllocator.
+// Components are relocated with memcpy and must be trivially copyable.
+template<typename Chunks = ChunkAllocator<>>
+class Archetype {
+public:
+    static constexpr uint32_t no_entity = UINT32_MAX;
+
+private:
+    struct Chunk {
+        uint8_t* mem;
+        uint32_t count;
+    };
+
+    Chunks* chunks;
+    std::vector<ComponentInfo> components;
+    std::vector<size_t> offsets;   // Column offsets; the entity id column is last
+    size_t capacity = 0;           // Rows per chunk
+    std::vector<Chunk> used;
+
+    size_t layout_bytes(size_t rows) const noexcept {
+        size_t end = 0;
+        for (const ComponentInfo& info : components) {
+            end = (end + info.alignment - 1) & ~(info.alignment - 1);
+            end += info.size * rows;
+        }
+        end = (end + alignof(uint32_t) - 1) & ~(alignof(uint32_t) - 1);
+        return end + sizeof(uint32_t) * rows;
+    }
+
+    uint32_t* entity_column(const Chunk& chunk) const noexcept {
+        return reinterpret_cast<uint32_t*>(chunk.mem + offsets.back());
+    }
+
+public:
+    // Lay out columns for the given components in chunks from `chunk_allocator`
+    Archetype(Chunks& chunk_allocator, std::span<const ComponentInfo> component_types)
+        : chunks(&chunk_allocator), components(component_types.begin(), component_types.end()) {
+        size_t row_bytes = sizeof(uint32_t);
+        for (const ComponentInfo& info : components) {
+            assert(std::has_single_bit(info.alignment) && info.alignment <= Chunks::chunk_alignment);
+            row_bytes += info.size;
+        }
+        capacity = Chunks::chunk_size / row_bytes;
+        while (capacity > 0 && layout_bytes(capacity) > Chunks::chunk_size) {
+            --capacity;
+        }
+        assert(capacity > 0 && "components do not fit in one chunk");
+
+        size_t end = 0;
+        for (const ComponentInfo& info : components) {
+            end = (end + info.alignment - 1) & ~(info.alignment - 1);
+            offsets.push_back(end);
+            end += info.size * capacity;
+        }
+        offsets.push_back((end + alignof(uint32_t) - 1) & ~(alignof(uint32_t) - 1));
+    }
+
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    ~Archetype() {
+        for (const Chunk& chunk : used) {
+            chunks->free(chunk.mem);
+        }
+    }
+
+    // Append a row for `entity`; its components are left uninitialized
+    [[nodiscard]] ChunkRow add(uint32_t entity) {
+        if (used.empty() || used.back().count == capacity) {
+            used.reserve(used.size() + 1); // Before taking the chunk, so it cannot leak
+            used.push_back({chunks->allocate(), 0});
+        }
+        Chunk& chunk = used.back();
+        entity_column(chunk)[chunk.count] = entity;
+        return {uint32_t(used.size() - 1), chunk.count++};
+    }
+
+    // Remove a row by moving the last row into it. Returns the entity that now
+    // occupies `location`, or no_entity if the removed row was the last one.
+    uint32_t remove(ChunkRow location) noexcept {
+        Chunk& last = used.back();
+        uint32_t last_row = last.count - 1;
+        uint32_t moved = no_entity;
+        if (location.chunk != used.size() - 1 || location.row != last_row) {
+            Chunk& target = used[location.chunk];
+            for (size_t c = 0; c < components.size(); ++c) {
+                size_t size = components[c].size;
+                std::memcpy(target.mem + offsets[c] + size * location.row,
+                            last.mem + offsets[c] + size * last_row, size);
+            }
+            moved = entity_column(last)[last_row];
+            entity_column(target)[location.row] = moved;
+        }
+        if (--last.count == 0) {
+            chunks->free(last.mem);
+            used.pop_back();
+        }
+        return moved;
+    }
+
+    // Raw column of component `component` in chunk `chunk`
+    [[nodiscard]] void* column(size_t chunk, size_t component) const noexcept {
+        return used[chunk].mem + offsets[component];
+    }
+
+    // Typed view of the live rows of a component column
+    template<typename T>
+    [[nodiscard]] std::span<T> column(size_t chunk, size_t component) const noexcept {
+        assert(sizeof(T) == components[component].size);
+        return {static_cast<T*>(column(chunk, component)), used[chunk].count};
+    }
+
+    // Entity ids of the live rows in a chunk
+    [[nodiscard]] std::span<const uint32_t> entities(size_t chunk) const noexcept {
+        return {entity_column(used[chunk]), used[chunk].count};
+    }
+
+    [[nodiscard]] size_t chunk_count() const noexcept { return used.size(); }
+    [[nodiscard]] size_t rows_per_chunk() const noexcept { return capacity; }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return used.empty() ? 0 : (used.size() - 1) * capacity + used.back().count;
+    }
+};
+
+// Offset Pointer Template Class
+// Pointer stored as the distance from itself to its target, so data
+// structures that use it stay valid wherever their memory is mapped
+// (persistent arenas, shared memory). Copies recompute the distance.
+template<typename T>
+class OffsetPtr {
+    static constexpr ptrdiff_t null_offset = 1; // 0 would be a pointer to itself
+
+    ptrdiff_t offset = null_offset;
+
+    void set(const T* ptr) noexcept {
+        offset = ptr ? reinterpret_cast<const uint8_t*>(ptr) - reinterpret_cast<const uint8_t*>(this) : null_offset;
+    }
+
+public:
+    OffsetPtr() noexcept = default;
+    OffsetPtr(std::nullptr_t) noexcept {}
+    OffsetPtr(T* ptr) noexcept { set(ptr); }
+    OffsetPtr(const OffsetPtr& other) noexcept { set(other.get()); }
+
+    OffsetPtr& operator=(const OffsetPtr& other) noexcept {
+        set(other.get());
+        return *this;
+    }
+
+    OffsetPtr& operator=(T* ptr) noexcept {
+        set(ptr);
+        return *this;
+    }
+
+    [[nodiscard]] T* get() const noexcept {
+        if (offset == null_offset) {
+            return nullptr;
+        }
+        return reinterpret_cast<T*>(const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(this)) + offset);
+    }
+
+    T& operator*() const noexcept { return *get(); }
+    T* operator->() const noexcept { return get(); }
+    explicit operator bool() const noexcept { return offset != null_offset; }
+
+    friend bool operator==(const OffsetPtr& a, const OffsetPtr& b) noexcept { return a.get() == b.get(); }
+};
+
+// Header of a baked arena image: this header, the arena bytes with internal
+// pointers stored as offsets, then the relocation table (offsets of those
+// pointers). Padded to 64 bytes so the data that follows is aligned; the
+// data is padded to 8 bytes so the table is too.
+struct ArenaImageHeader {
+    static constexpr uint64_t magic_value = 0x474D49414D504D43; // "CMPMAIMG" read as little-endian
+    static constexpr uint64_t current_version = 1;
+
+    uint64_t magic = magic_value;
+    uint64_t version = current_version;
+    uint64_t data_size = 0;
+    uint64_t relocation_count = 0;
+    uint64_t root = 0;          // Offset of the root object
+    uint64_t reserved[3] = {};
+};
+
+// Arena Image Writer Class
+// Bakes the used part of a LinearAllocator into an image file. Register
+// every pointer field that points into the arena with add_pointer(); the
+// image stores those as offsets plus a table of where they are, which
+// ArenaImage turns back into pointers in one pass at load time.
+class ArenaImageWriter {
+    const LinearAllocator* arena;
+    std::vector<uint64_t> relocations;
+
+public:
+    explicit ArenaImageWriter(const LinearAllocator& source) noexcept : arena(&source) {}
+
+    // Record a pointer field stored in the arena; its target must be in the arena or null
+    template<typename T>
+    void add_pointer(T* const& field) {
+        relocations.push_back(uint64_t(reinterpret_cast<const uint8_t*>(&field) - arena->base()));
+    }
+
+    // Write the image; false on an I/O error or a registered pointer that
+    // lies outside the arena or points outside it
+    [[nodiscard]] bool write(std::FILE* out, const void* root) const {
+        const uint8_t* base = arena->base();
+        size_t size = arena->used();
+        std::vector<uint8_t> data((size + 7) & ~size_t(7), 0);
+        std::copy(base, base + size, data.begin());
+        std::vector<uint64_t> table;
+        table.reserve(relocations.size());
+        for (uint64_t at : relocations) {
+            if (at + sizeof(void*) > size) {
+                return false;
+            }
+            const uint8_t* target;
+            std::memcpy(&target, data.data() + at, sizeof(target));
+            if (!target) {
+                continue; // Null stays zero and needs no fixup
+            }
+            if (target < base || target > base + size) {
+                return false;
+            }
+            uint64_t offset = uint64_t(target - base);
+            std::memcpy(data.data() + at, &offset, sizeof(offset));
+            table.push_back(at);
+        }
+        ArenaImageHeader header;
+        header.data_size = data.size();
+        header.relocation_count = table.size();
+        header.root = root ? uint64_t(static_cast<const uint8_t*>(root) - base) : 0;
+        return std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+               std::fwrite(data.data(), 1, data.size(), out) == data.size() &&
+               std::fwrite(table.data(), sizeof(uint64_t), table.size(), out) == table.size();
+    }
+};
+
+// Arena Image Class
+// Loads an image written by ArenaImageWriter with one bulk read (or, on
+// POSIX, a private mapping) and converts its stored offsets back into
+// pointers in a single branch-free pass over the relocation table. Objects
+// may need at most alignof(std::max_align_t) when read, 64 when mapped.
+class ArenaImage {
+    static_assert(sizeof(void*) == sizeof(uint64_t), "images store 64-bit pointers");
+
+    uint8_t* memory = nullptr;  // Start of the loaded data
+    size_t data_size = 0;
+    uint64_t root_offset = 0;
+    void* mapping = nullptr;    // Set when mapped rather than read
+    size_t mapping_size = 0;
+
+    bool valid(const ArenaImageHeader& header, size_t available) const noexcept {
+        return header.magic == ArenaImageHeader::magic_value && header.version == ArenaImageHeader::current_version &&
+               header.data_size % sizeof(uint64_t) == 0 &&
+               header.relocation_count <= (SIZE_MAX - header.data_size) / sizeof(uint64_t) &&
+               header.data_size + header.relocation_count * sizeof(uint64_t) <= available &&
+               header.root <= header.data_size;
+    }
+
+    // Turn offsets into pointers. The table is checked with a branch-free
+    // reduction that compilers vectorize; patching is then one load, add and
+    // store per entry with no per-entry checks.
+    static bool fix_up(uint8_t* data, size_t size, const uint64_t* table, size_t count) noexcept {
+        if (count > 0 && size < sizeof(uint64_t)) {
+            return false;
+        }
+        uint64_t bad = 0;
+        for (size_t i = 0; i < count; ++i) {
+            bad |= uint64_t(table[i] > size - sizeof(uint64_t));
+        }
+        if (bad) {
+            return false; // Corrupt table
+        }
+        uint64_t base = reinterpret_cast<uintptr_t>(data);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t value;
+            std::memcpy(&value, data + table[i], sizeof(value));
+            value += base;
+            std::memcpy(data + table[i], &value, sizeof(value));
+        }
+        return true;
+    }
+
+public:
+    ArenaImage() = default;
+    ArenaImage(const ArenaImage&) = delete;
+    ArenaImage& operator=(const ArenaImage&) = delete;
+
+    ~ArenaImage() {
+        release();
+    }
+
+    // Read an image from `in`; false if it is truncated or not an image
+    [[nodiscard]] bool load(std::FILE* in) noexcept {
+        release();
+        ArenaImageHeader header;
+        if (std::fread(&header, sizeof(header), 1, in) != 1 || !valid(header, SIZE_MAX)) {
+            return false;
+        }
+        size_t table_bytes = header.relocation_count * sizeof(uint64_t);
+        size_t total = header.data_size + table_bytes;
+        auto* buffer = static_cast<uint8_t*>(ALLOCATOR_ALLOC(total ? total : 1));
+        if (!buffer) {
+            return false;
+        }
+        if (std::fread(buffer, 1, total, in) != total) {
+            ALLOCATOR_FREE(buffer);
+            return false;
+        }
+        auto* table = reinterpret_cast<const uint64_t*>(buffer + header.data_size);
+        if (!fix_up(buffer, header.data_size, table, header.relocation_count)) {
+            ALLOCATOR_FREE(buffer);
+            return false;
+        }
+        memory = buffer;
+        data_size = header.data_size;
+        root_offset = header.root;
+        return true;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    // Map an image file copy-on-write: only pages holding pointers are copied
+    // by the fixup, the rest stay shared with the page cache and load lazily
+    [[nodiscard]] bool map(const char* path) noexcept {
+        release();
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(ArenaImageHeader)) {
+            ::close(fd);
+            return false;
+        }
+        size_t size = size_t(st.st_size);
+        void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mem == MAP_FAILED) {
+            return false;
+        }
+        ArenaImageHeader header;
+        std::memcpy(&header, mem, sizeof(header));
+        auto* data = static_cast<uint8_t*>(mem) + sizeof(header);
+        if (!valid(header, size - sizeof(header)) ||
+            !fix_up(data, header.data_size, reinterpret_cast<const uint64_t*>(data + header.data_size),
+                    header.relocation_count)) {
+            munmap(mem, size);
+            return false;
+        }
+        mapping = mem;
+        mapping_size = size;
+        memory = data;
+        data_size = header.data_size;
+        root_offset = header.root;
+        return true;
+    }
+#endif
+
+    void release() noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapping) {
+            munmap(mapping, mapping_size);
+            mapping = nullptr;
+            memory = nullptr;
+        }
+#endif
+        if (memory) {
+            ALLOCATOR_FREE(memory);
+            memory = nullptr;
+        }
+        data_size = 0;
+        root_offset = 0;
+    }
+
+    template<typename T>
+    [[nodiscard]] T* root() const noexcept {
+        return memory ? reinterpret_cast<T*>(memory + root_offset) : nullptr;
+    }
+
+    [[nodiscard]] uint8_t* data() const noexcept { return memory; }
+    [[nodiscard]] size_t size() const noexcept { return data_size; }
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+
+// Large Object Allocator Class
+// Serves big buffers straight from mmap, bypassing pools and arenas. Recently
+// freed mappings are kept in a small cache and handed back to requests of a
+// similar size, and on Linux reallocate() grows a mapping with mremap so the
+// kernel moves page-table entries instead of copying the contents.
+class LargeObjectAllocator {
+public:
+    // Requests at or above this size are worth a dedicated mapping
+    static constexpr size_t default_threshold = size_t(256) << 10;
+
+private:
+    static constexpr size_t header_size = 16; // Keeps payloads 16-byte aligned
+    static constexpr size_t cache_slots = 16;
+
+    // Stored at the start of every mapping
+    struct Header {
+        size_t mapped; // Size of the whole mapping
+    };
+
+    struct Span {
+        void* base;
+        size_t size;
+    };
+
+    Span cache[cache_slots] = {};  // Freed mappings, oldest first
+    size_t cache_count = 0;
+    size_t cache_bytes = 0;
+    size_t max_cache_bytes;
+    [[no_unique_address]] StatsCounters<> counters;
+
+    static size_t page_size() noexcept {
+        static const size_t size = size_t(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    static size_t mapping_size(size_t size) noexcept {
+        size_t page = page_size();
+        return (size + header_size + page - 1) & ~(page - 1);
+    }
+
+    static Header* header_of(void* ptr) noexcept {
+        return reinterpret_cast<Header*>(static_cast<uint8_t*>(ptr) - header_size);
+    }
+
+    static uint8_t* payload(void* base, size_t mapped) noexcept {
+        static_cast<Header*>(base)->mapped = mapped;
+        return static_cast<uint8_t*>(base) + header_size;
+    }
+
+    void evict(size_t slot) noexcept {
+        EventScope<> event("munmap", this, cache[slot].size);
+        munmap(cache[slot].base, cache[slot].size);
+        counters.on_block_released();
+        cache_bytes -= cache[slot].size;
+        std::copy(cache + slot + 1, cache + cache_count, cache + slot);
+        --cache_count;
+    }
+
+    // Take the smallest cached mapping that fits without wasting more than a quarter
+    Span take_cached(size_t mapped) noexcept {
+        size_t best = cache_count;
+        for (size_t i = 0; i < cache_count; ++i) {
+            size_t size = cache[i].size;
+            if (size >= mapped && size - mapped <= mapped / 4 && (best == cache_count || size < cache[best].size)) {
+                best = i;
+            }
+        }
+        if (best == cache_count) {
+            return {nullptr, 0};
+        }
+        Span span = cache[best];
+        cache_bytes -= span.size;
+        std::copy(cache + best + 1, cache + cache_count, cache + best);
+        --cache_count;
+        return span;
+    }
+
+public:
+    // Keep up to max_cached_bytes of freed mappings for reuse
+    explicit LargeObjectAllocator(size_t max_cached_bytes = size_t(64) << 20) noexcept
+        : max_cache_bytes(max_cached_bytes) {}
+
+    LargeObjectAllocator(const LargeObjectAllocator&) = delete;
+    LargeObjectAllocator& operator=(const LargeObjectAllocator&) = delete;
+
+    ~LargeObjectAllocator() {
+        trim();
+    }
+
+    // Allocate a buffer in its own mapping (or a cached one)
+    [[nodiscard]] uint8_t* allocate(size_t size) noexcept {
+        if (size > SIZE_MAX / 2) {
+            counters.on_failure();
+            return nullptr;
+        }
+        size_t mapped = mapping_size(size);
+        Span span = take_cached(mapped);
+        if (!span.base) {
+            EventScope<> event("mmap", this, mapped);
+            void* base = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (base == MAP_FAILED) {
+                counters.on_failure();
+                return nullptr;
+            }
+            counters.on_block_acquired();
+            span = {base, mapped};
+        }
+        counters.on_allocate(span.size);
+        return payload(span.base, span.size);
+    }
+
+    // Free a buffer, caching its mapping if it fits the cache budget
+    void free(void* ptr) noexcept {
+        if (!ptr) {
+            return;
+        }
+        Header* header = header_of(ptr);
+        size_t mapped = header->mapped;
+        counters.on_free(mapped);
+        if (mapped > max_cache_bytes) {
+            EventScope<> event("munmap", this, mapped);
+            munmap(header, mapped);
+            counters.on_block_released();
+            return;
+        }
+        if (cache_count == cache_slots || cache_bytes + mapped > max_cache_bytes) {
+            EventScope<> event("cache_flush", this, cache_bytes);
+            while (cache_count > 0 && (cache_count == cache_slots || cache_bytes + mapped > max_cache_bytes)) {
+                evict(0); // Drop the oldest
+            }
+        }
+        cache[cache_count++] = {header, mapped};
+        cache_bytes += mapped;
+    }
+
+    // Resize a buffer, keeping its contents; returns nullptr (and leaves ptr intact) on failure
+    [[nodiscard]] uint8_t* reallocate(void* ptr, size_t new_size) noexcept {
+        if (!ptr) {
+            return allocate(new_size);
+        }
+        if (new_size > SIZE_MAX / 2) {
+            return nullptr;
+        }
+        Header* header = header_of(ptr);
+        size_t mapped = header->mapped;
+        size_t needed = mapping_size(new_size);
+        if (needed <= mapped) {
+            // Shrink in place, returning whole tail pages
+            if (needed < mapped) {
+                munmap(reinterpret_cast<uint8_t*>(header) + needed, mapped - needed);
+                header->mapped = needed;
+                counters.on_upstream_call();
+                counters.on_resize(mapped, needed);
+            }
+            return static_cast<uint8_t*>(ptr);
+        }
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+        void* base = mremap(header, mapped, needed, MREMAP_MAYMOVE);
+        counters.on_upstream_call();
+        if (base == MAP_FAILED) {
+            counters.on_failure();
+            return nullptr;
+        }
+        counters.on_resize(mapped, needed);
+        return payload(base, needed);
+#else
+        uint8_t* grown = allocate(new_size);
+        if (!grown) {
+            return nullptr;
+        }
+        std::memcpy(grown, ptr, mapped - header_size);
+        free(ptr);
+        return grown;
+#endif
+    }
+
+    // Bytes usable at ptr, which may exceed the requested size
+    [[nodiscard]] static size_t usable_size(const void* ptr) noexcept {
+        return header_of(const_cast<void*>(ptr))->mapped - header_size;
+    }
+
+    // Unmap every cached mapping
+    void trim() noexcept {
+        if (cache_count == 0) {
+            return;
+        }
+        EventScope<> event("trim", this, cache_bytes);
+        while (cache_count > 0) {
+            evict(cache_count - 1);
+        }
+    }
+
+    // Bytes held in cached mappings
+    [[nodiscard]] size_t cached_bytes() const noexcept {
+        return cache_bytes;
+    }
+
+    // Usage counters; all zero unless ALLOCATOR_STATS is defined. bytes_live
+    // counts whole mappings and blocks counts mappings, cached ones included.
+    [[nodiscard]] AllocatorStats stats() const noexcept {
+        return counters.snapshot();
+    }
+
+    // Byte-sized interface for use as an upstream
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept {
+        return allocate(size);
+    }
+
+    void deallocate_bytes(void* ptr, size_t) noexcept {
+        free(ptr);
+    }
+};
+
+// Persistent Arena Class
+// Bump arena inside a file mapped with MAP_SHARED. The file starts with a
+// header (magic, versions, size, bump offset, root object), so structures
+// built with OffsetPtr links can be reopened at the next start without any
+// parsing: pages load lazily as they are first touched. Objects must not hold
+// raw pointers or anything owning memory outside the arena.
+class PersistentArena {
+    struct Header {
+        uint64_t magic;
+        uint32_t layout_version;  // Of this header
+        uint32_t user_version;    // Of the caller's data structures
+        uint64_t size;            // Bytes in the file
+        uint64_t used;            // Bump offset from the start of the file
+        uint64_t root;            // Offset of the root object, 0 if none
+    };
+
+    static constexpr size_t data_start = 64; // Header padded to a cache line
+
+    uint8_t* base = nullptr;
+    size_t mapped = 0;
+
+    Header* header() const noexcept { return reinterpret_cast<Header*>(base); }
+
+public:
+    static constexpr uint64_t magic = 0x414E524141504D43; // "CMPAARNA" read as little-endian
+    static constexpr uint32_t layout_version = 1;
+
+    PersistentArena() = default;
+    PersistentArena(const PersistentArena&) = delete;
+    PersistentArena& operator=(const PersistentArena&) = delete;
+
+    ~PersistentArena() {
+        close();
+    }
+
+    // Map `path`, creating it with `capacity` bytes if it does not exist or is
+    // empty. An existing file keeps its own size and contents; false if it
+    // cannot be opened or was written by another layout or user_version.
+    // Until open() succeeds no file is mapped: allocate(), create() and root()
+    // return nullptr, and set_root(), reset() and flush() do nothing.
+    [[nodiscard]] bool open(const char* path, size_t capacity, uint32_t user_version = 0) noexcept {
+        close();
+        int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        bool fresh = st.st_size == 0;
+        size_t size = fresh ? std::max(capacity, data_start) : size_t(st.st_size);
+        if ((fresh && ftruncate(fd, off_t(size)) != 0) || size < data_start) {
+            ::close(fd);
+            return false;
+        }
+        void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd); // The mapping keeps the file open
+        if (mem == MAP_FAILED) {
+            return false;
+        }
+        base = static_cast<uint8_t*>(mem);
+        mapped = size;
+        Header* h = header();
+        if (fresh) {
+            *h = {magic, layout_version, user_version, size, data_start, 0};
+        } else if (h->magic != magic || h->layout_version != layout_version || h->user_version != user_version ||
+                   h->size != size || h->used < data_start || h->used > size || h->root >= size) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Write dirty pages back to the file and wait for them
+    void flush() noexcept {
+        if (base) {
+            msync(base, mapped, MS_SYNC);
+        }
+    }
+
+    // Unmap the file; its contents stay as they are
+    void close() noexcept {
+        if (base) {
+            munmap(base, mapped);
+            base = nullptr;
+            mapped = 0;
+        }
+    }
+
+    [[nodiscard]] bool is_open() const noexcept { return base != nullptr; }
+
+    // Allocate from the arena; nullptr when the file is full
+    [[nodiscard]] void* allocate(size_t size, size_t align = alignof(std::max_align_t)) noexcept {
+        if (!base) {
+            return nullptr;
+        }
+        Header* h = header();
+        size_t start = (h->used + align - 1) & ~(align - 1);
+        if (start > mapped || size > mapped - start) {
+            return nullptr;
+        }
+        h->used = start + size;
+        return base + start;
+    }
+
+    // Allocate and construct a T in the arena
+    template<typename T, typename... Args>
+    [[nodiscard]] T* create(Args&&... args) {
+        void* mem = allocate(sizeof(T), alignof(T));
+        return mem ? std::construct_at(static_cast<T*>(mem), std::forward<Args>(args)...) : nullptr;
+    }
+
+    // The object to start from after reopening; nullptr in a new file
+    template<typename T>
+    [[nodiscard]] T* root() const noexcept {
+        return base && header()->root ? reinterpret_cast<T*>(base + header()->root) : nullptr;
+    }
+
+    void set_root(const void* object) noexcept {
+        if (!base) {
+            return;
+        }
+        header()->root = object ? uint64_t(static_cast<const uint8_t*>(object) - base) : 0;
+    }
+
+    // Drop every object; the file keeps its size
+    void reset() noexcept {
+        if (!base) {
+            return;
+        }
+        header()->used = data_start;
+        header()->root = 0;
+    }
+
+    [[nodiscard]] size_t used() const noexcept { return base ? header()->used : 0; }
+    [[nodiscard]] size_t capacity() const noexcept { return mapped; }
+
+    // Byte interface; frees are ignored until reset()
+    [[nodiscard]] void* allocate_bytes(size_t size) noexcept { return allocate(size); }
+    void deallocate_bytes(void*, size_t) noexcept {}
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept {
+        return base && ptr >= base + data_start && ptr < base + mapped;
+    }
+};
+
+// Shared Segment Class
+// Shared memory mapped by several processes: a named POSIX shm object, or
+// on Linux an anonymous memfd whose descriptor is passed to the other
+// processes (inherited, or sent over a Unix socket). Each process may map it
+// at a different address, so structures inside use offsets or OffsetPtr.
+class SharedSegment {
+    uint8_t* base = nullptr;
+    size_t mapped = 0;
+    int descriptor = -1;
+
+    bool map_descriptor(int fd, size_t size) noexcept {
+        void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mem == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        base = static_cast<uint8_t*>(mem);
+        mapped = size;
+        descriptor = fd;
+        return true;
+    }
+
+public:
+    SharedSegment() = default;
+    SharedSegment(const SharedSegment&) = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    ~SharedSegment() {
+        close();
+    }
+
+    // Create a named segment of `size` bytes; fails if the name exists
+    [[nodiscard]] bool create(const char* name, size_t size) noexcept {
+        close();
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) {
+            return false;
+        }
+        if (ftruncate(fd, off_t(size)) != 0) {
+            ::close(fd);
+            shm_unlink(name);
+            return false;
+        }
+        return map_descriptor(fd, size);
+    }
+
+    // Map an existing named segment
+    [[nodiscard]] bool open(const char* name) noexcept {
+        close();
+        int fd = shm_open(name, O_RDWR, 0);
+        return fd >= 0 && attach(fd);
+    }
+
+#if defined(__linux__)
+    // Create an anonymous segment; share it through fd()
+    [[nodiscard]] bool create_anonymous(size_t size) noexcept {
+        close();
+        int fd = memfd_create("cpp_minallocator-shared", MFD_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        if (ftruncate(fd, off_t(size)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        return map_descriptor(fd, size);
+    }
+#endif
+
+    // Map the segment behind a descriptor received from another process; takes ownership of fd
+    [[nodiscard]] bool attach(int fd) noexcept {
+        close();
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        return map_descriptor(fd, size_t(st.st_size));
+    }
+
+    // Remove a named segment; processes that mapped it keep their mappings
+    static bool remove(const char* name) noexcept {
+        return shm_unlink(name) == 0;
+    }
+
+    void close() noexcept {
+        if (base) {
+            munmap(base, mapped);
+            ::close(descriptor);
+            base = nullptr;
+            mapped = 0;
+            descriptor = -1;
+        }
+    }
+
+    [[nodiscard]] void* data() const noexcept { return base; }
+    [[nodiscard]] size_t size() const noexcept { return mapped; }
+    [[nodiscard]] int fd() const noexcept { return descriptor; }
+};
+
+// Shared Pool Class
+// Fixed-size slots in shared memory, usable by several processes at once.
+// Free slots form a lock-free Treiber stack of slot indexes whose head
+// carries a tag against ABA; slots are carved from the region on demand.
+// Every slot records the pid of the process responsible for it, so
+// reclaim_dead() can return the slots of a participant that crashed. A
+// consumer that takes over a slot from a producer calls adopt() first.
+class SharedPool {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                  "process-shared atomics must be lock-free");
+
+    struct Control {
+        uint64_t magic;
+        uint64_t slot_size;               // Payload bytes, rounded to 16
+        uint64_t slot_count;
+        std::atomic<uint64_t> head;       // Tag in the high half, index + 1 in the low half; 0 when empty
+        std::atomic<uint64_t> carved;     // Slots ever handed out; may overshoot slot_count
+    };
+
+    struct SlotHeader {
+        std::atomic<uint32_t> owner;      // Pid responsible for the slot, 0 when free
+        std::atomic<uint32_t> next;       // Index + 1 of the next free slot
+        uint64_t reserved;                // Keeps the payload 16-byte aligned
+    };
+
+    static constexpr uint64_t magic_value = 0x4C4F4F5048534D43; // "CMSHPOOL" read as little-endian
+    static constexpr size_t control_size = 64;
+
+    uint8_t* base = nullptr;
+    Control* control = nullptr;
+    size_t stride = 0;
+    uint32_t self = 0;
+
+    SlotHeader* slot(uint64_t index) const noexcept {
+        return reinterpret_cast<SlotHeader*>(base + control_size + index * stride);
+    }
+
+    void push(uint32_t index) noexcept {
+        uint64_t head = control->head.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            slot(index)->next.store(uint32_t(head), std::memory_order_relaxed);
+            next = ((head >> 32) + 1) << 32 | (uint64_t(index) + 1);
+        } while (!control->head.compare_exchange_weak(head, next, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+    }
+
+    bool pop(uint32_t& index) noexcept {
+        uint64_t head = control->head.load(std::memory_order_acquire);
+        while (uint32_t top = uint32_t(head)) {
+            // A stale read of next is harmless: the tag makes the exchange fail
+            uint32_t after = slot(top - 1)->next.load(std::memory_order_relaxed);
+            uint64_t next = ((head >> 32) + 1) << 32 | after;
+            if (control->head.compare_exchange_weak(head, next, std::memory_order_acquire,
+                                                    std::memory_order_acquire)) {
+                index = top - 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool alive(uint32_t pid) noexcept {
+        return kill(pid_t(pid), 0) == 0 || errno != ESRCH;
+    }
+
+public:
+    // Lay out a new pool in `mem` (size bytes, e.g. a SharedSegment) before any process uses it
+    [[nodiscard]] bool init(void* mem, size_t size, size_t slot_size) noexcept {
+        size_t payload = (std::max<size_t>(slot_size, 1) + 15) & ~size_t(15);
+        if (size < control_size + sizeof(SlotHeader) + payload) {
+            return false;
+        }
+        base = static_cast<uint8_t*>(mem);
+        control = reinterpret_cast<Control*>(base);
+        stride = sizeof(SlotHeader) + payload;
+        control->slot_size = payload;
+        control->slot_count = std::min<size_t>((size - control_size) / stride, UINT32_MAX - 1);
+        new (&control->head) std::atomic<uint64_t>(0);
+        new (&control->carved) std::atomic<uint64_t>(0);
+        std::atomic_thread_fence(std::memory_order_release);
+        control->magic = magic_value;
+        self = uint32_t(getpid());
+        return true;
+    }
+
+    // Use a pool another process laid out with init(); call again after fork()
+    [[nodiscard]] bool attach(void* mem) noexcept {
+        base = static_cast<uint8_t*>(mem);
+        control = reinterpret_cast<Control*>(base);
+        if (control->magic != magic_value) {
+            base = nullptr;
+            control = nullptr;
+            return false;
+        }
+        stride = sizeof(SlotHeader) + control->slot_size;
+        self = uint32_t(getpid());
+        return true;
+    }
+
+    // Allocate one slot owned by this process; nullptr when the pool is exhausted
+    [[nodiscard]] void* allocate() noexcept {
+        uint32_t index;
+        if (!pop(index)) {
+            uint64_t fresh = control->carved.fetch_add(1, std::memory_order_relaxed);
+            if (fresh >= control->slot_count) {
+                return nullptr;
+            }
+            index = uint32_t(fresh);
+        }
+        slot(index)->owner.store(self, std::memory_order_relaxed);
+        return slot(index) + 1;
+    }
+
+    // Return a slot; any process may free any slot
+    void free(void* ptr) noexcept {
+        SlotHeader* header = static_cast<SlotHeader*>(ptr) - 1;
+        header->owner.store(0, std::memory_order_relaxed);
+        push(uint32_t((reinterpret_cast<uint8_t*>(header) - base - control_size) / stride));
+    }
+
+    // Take responsibility for a slot received from another process, so it is
+    // not reclaimed if that process dies
+    void adopt(void* ptr) noexcept {
+        (static_cast<SlotHeader*>(ptr) - 1)->owner.store(self, std::memory_order_relaxed);
+    }
+
+    // Free every slot whose owning process no longer exists; returns how many.
+    // A process that dies between taking a slot and recording itself as owner
+    // leaks that one slot.
+    size_t reclaim_dead() noexcept {
+        size_t reclaimed = 0;
+        uint64_t carved = std::min<uint64_t>(control->carved.load(std::memory_order_relaxed), control->slot_count);
+        for (uint64_t i = 0; i < carved; ++i) {
+            uint32_t owner = slot(i)->owner.load(std::memory_order_relaxed);
+            if (owner != 0 && owner != self && !alive(owner) &&
+                slot(i)->owner.compare_exchange_strong(owner, 0, std::memory_order_relaxed)) {
+                push(uint32_t(i));
+                ++reclaimed;
+            }
+        }
+        return reclaimed;
+    }
+
+    // Position of a slot within the shared memory, meaningful in every process
+    [[nodiscard]] uint64_t offset_of(const void* ptr) const noexcept {
+        return uint64_t(static_cast<const uint8_t*>(ptr) - base);
+    }
+
+    [[nodiscard]] void* at(uint64_t offset) const noexcept { return base + offset; }
+
+    [[nodiscard]] size_t slot_size() const noexcept { return control->slot_size; }
+    [[nodiscard]] size_t slot_count() const noexcept { return control->slot_count; }
+};
+
+// Shared Arena Class
+// Bump arena in shared memory; processes allocate concurrently with one
+// compare-exchange each. Memory comes back only through reset(), which the
+// participants must agree on (e.g. once per pipeline batch, or after a
+// crashed participant's messages are abandoned).
+class SharedArena {
+    struct Control {
+        uint64_t magic;
+        uint64_t size;
+        std::atomic<uint64_t> used;       // Bump offset from the start of the memory
+    };
+
+    static constexpr uint64_t magic_value = 0x414E524148534D43; // "CMSHARNA" read as little-endian
+    static constexpr size_t control_size = 64;
+
+    uint8_t* base = nullptr;
+    Control* control = nullptr;
+
+public:
+    // Lay out a new arena in `mem` before any process uses it
+    [[nodiscard]] bool init(void* mem, size_t size) noexcept {
+        if (size < control_size) {
+            return false;
+        }
+        base = static_cast<uint8_t*>(mem);
+        control = reinterpret_cast<Control*>(base);
+        control->size = size;
+        new (&control->used) std::atomic<uint64_t>(control_size);
+        std::atomic_thread_fence(std::memory_order_release);
+        control->magic = magic_value;
+        return true;
+    }
+
+    // Use an arena another process laid out with init()
+    [[nodiscard]] bool attach(void* mem) noexcept {
+        base = static_cast<uint8_t*>(mem);
+        control = reinterpret_cast<Control*>(base);
+        if (control->magic != magic_value) {
+            base = nullptr;
+            control = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    // Allocate `size` bytes; nullptr when the arena is full
+    [[nodiscard]] void* allocate(size_t size, size_t align = alignof(std::max_align_t)) noexcept {
+        uint64_t used = control->used.load(std::memory_order_relaxed);
+        uint64_t start;
+        do {
+            start = (used + align - 1) & ~uint64_t(align - 1);
+            if (start > control->size || size > control->size - start) {
+                return nullptr;
+            }
+        } while (!control->used.compare_exchange_weak(used, start + size, std::memory_order_relaxed));
+        return base + start;
+    }
+
+    // Discard every allocation, in every process
+    void reset() noexcept {
+        control->used.store(control_size, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t offset_of(const void* ptr) const noexcept {
+        return uint64_t(static_cast<const uint8_t*>(ptr) - base);
+    }
+
+    [[nodiscard]] void* at(uint64_t offset) const noexcept { return base + offset; }
+
+    [[nodiscard]] size_t used() const noexcept { return control->used.load(std::memory_order_relaxed); }
+    [[nodiscard]] size_t capacity() const noexcept { return control->size; }
+};
+
+#endif // defined(__unix__) || defined(__APPLE__)
+
+#if defined(__linux__)
+
+// Meshing Block Allocator Template Class
+// A BlockAllocator variant whose blocks live in a memfd and are mapped into
+// one reserved address range. mesh() finds pairs of sparse blocks whose
+// occupied slots do not overlap, copies the live objects of one into the
+// other's physical pages at the same offsets, and remaps the emptied block's
+// virtual pages onto them. The freed physical pages go back to the kernel and
+// every object keeps its address (the Mesh technique).
+template<Constructible T, size_t block_size = 256>
+class MeshingBlockAllocator {
+    static constexpr size_t words = (block_size + 63) / 64;
+
+    // A block of physical memory (a range of the memfd) and the views mapping it
+    struct Physical {
+        size_t offset = 0;            // Offset of the pages in the memfd
+        size_t live = 0;              // Occupied slots
+        std::vector<uint32_t> views;  // Virtual blocks mapped onto these pages
+        bool alive = false;
+    };
+
+    int fd = -1;
+    uint8_t* base = nullptr;          // Start of the reserved virtual range
+    size_t span_bytes = 0;            // Block size rounded up to whole pages
+    size_t max_views = 0;
+    size_t next_view = 0;
+    size_t file_size = 0;
+
+    std::vector<Physical> physicals;
+    std::vector<uint64_t> occupancy;  // `words` bitmap words per physical block
+    std::vector<uint32_t> view_to_physical;
+    std::vector<uint32_t> partial;    // Physical blocks with at least one free slot
+    std::vector<uint32_t> dead;       // Reusable Physical records
+    std::vector<size_t> free_offsets; // Punched-out memfd ranges available for reuse
+
+    uint64_t* bits_of(size_t phys) noexcept { return occupancy.data() + phys * words; }
+
+    uint8_t* view_address(size_t view) const noexcept { return base + view * span_bytes; }
+
+    bool map_view(size_t view, size_t offset) noexcept {
+        EventScope<> event("mmap", this, span_bytes);
+        void* mem = mmap(view_address(view), span_bytes, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_FIXED, fd, off_t(offset));
+        return mem != MAP_FAILED;
+    }
+
+    // Create a block with fresh physical pages and a fresh view
+    uint32_t new_block() {
+        if (next_view == max_views) {
+            throw std::bad_alloc(); // Reserved range exhausted
+        }
+        size_t offset;
+        if (!free_offsets.empty()) {
+            offset = free_offsets.back();
+            free_offsets.pop_back();
+        } else {
+            if (ftruncate(fd, off_t(file_size + span_bytes)) != 0) {
+                throw std::bad_alloc();
+            }
+            offset = file_size;
+            file_size += span_bytes;
+        }
+        size_t view = next_view;
+        if (!map_view(view, offset)) {
+            free_offsets.push_back(offset);
+            throw std::bad_alloc();
+        }
+        ++next_view;
+
+        uint32_t phys;
+        if (!dead.empty()) {
+            phys = dead.back();
+            dead.pop_back();
+        } else {
+            phys = uint32_t(physicals.size());
+            physicals.emplace_back();
+            occupancy.resize(occupancy.size() + words, 0);
+        }
+        Physical& block = physicals[phys];
+        block.offset = offset;
+        block.live = 0;
+        block.views.assign(1, uint32_t(view));
+        block.alive = true;
+        std::fill_n(bits_of(phys), words, 0);
+        view_to_physical.push_back(phys);
+        return phys;
+    }
+
+    bool disjoint(size_t a, size_t b) noexcept {
+        const uint64_t* bits_a = bits_of(a);
+        const uint64_t* bits_b = bits_of(b);
+        for (size_t w = 0; w < words; ++w) {
+            if (bits_a[w] & bits_b[w]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Move the contents of `src` into `dst` and point all of src's views at dst's pages
+    bool merge(uint32_t dst, uint32_t src) {
+        Physical& to = physicals[dst];
+        Physical& from = physicals[src];
+        uint8_t* to_mem = view_address(to.views[0]);
+        uint8_t* from_mem = view_address(from.views[0]);
+        uint64_t* to_bits = bits_of(dst);
+        const uint64_t* from_bits = bits_of(src);
+        for (size_t w = 0; w < words; ++w) {
+            for (uint64_t bits = from_bits[w]; bits; bits &= bits - 1) {
+                size_t offset = (w * 64 + std::countr_zero(bits)) * sizeof(T);
+                std::memcpy(to_mem + offset, from_mem + offset, sizeof(T));
+            }
+        }
+        for (size_t i = 0; i < from.views.size(); ++i) {
+            if (!map_view(from.views[i], to.offset)) {
+                // Not expected once the range is reserved; point the views
+                // already switched back at src so it stays intact
+                while (i-- > 0) {
+                    map_view(from.views[i], from.offset);
+                }
+                return false;
+            }
+        }
+        for (uint32_t view : from.views) {
+            view_to_physical[view] = dst;
+            to.views.push_back(view);
+        }
+        for (size_t w = 0; w < words; ++w) {
+            to_bits[w] |= from_bits[w];
+        }
+        to.live += from.live;
+
+        // Hand the source pages back to the kernel
+        fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, off_t(from.offset), off_t(span_bytes));
+        free_offsets.push_back(from.offset);
+        from.views.clear();
+        from.alive = false;
+        dead.push_back(src);
+        std::erase(partial, src);
+        if (to.live == block_size) {
+            std::erase(partial, dst);
+        }
+        return true;
+    }
+
+public:
+    // Reserve address space for up to max_blocks blocks
+    explicit MeshingBlockAllocator(size_t max_blocks = 4096) {
+        size_t page = size_t(sysconf(_SC_PAGESIZE));
+        span_bytes = (sizeof(T) * block_size + page - 1) & ~(page - 1);
+        max_views = max_blocks;
+        fd = memfd_create("cpp_minallocator-mesh", MFD_CLOEXEC);
+        if (fd < 0) {
+            throw std::bad_alloc();
+        }
+        void* mem = mmap(nullptr, span_bytes * max_views, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mem == MAP_FAILED) {
+            close(fd);
+            throw std::bad_alloc();
+        }
+        base = static_cast<uint8_t*>(mem);
+    }
+
+    MeshingBlockAllocator(const MeshingBlockAllocator&) = delete;
+    MeshingBlockAllocator& operator=(const MeshingBlockAllocator&) = delete;
+
+    // Allocate an object of type T
+    template<typename... Args>
+    [[nodiscard]] T* allocate(Args&&... args) {
+        if (partial.empty()) {
+            partial.push_back(new_block());
+        }
+        uint32_t phys = partial.back();
+        Physical& block = physicals[phys];
+        uint64_t* bits = bits_of(phys);
+        size_t w = 0;
+        while (bits[w] == ~uint64_t(0)) {
+            ++w;
+        }
+        size_t slot = w * 64 + std::countr_one(bits[w]);
+        T* ptr = reinterpret_cast<T*>(view_address(block.views[0])) + slot;
+        new (ptr) T(std::forward<Args>(args)...); // Construct in-place
+        bits[w] |= uint64_t(1) << (slot % 64);
+        if (++block.live == block_size) {
+            partial.pop_back();
+        }
+        return ptr;
+    }
+
+    // Free an object of type T
+    void free(T* ptr) {
+        size_t offset = size_t(reinterpret_cast<uint8_t*>(ptr) - base);
+        uint32_t phys = view_to_physical[offset / span_bytes];
+        size_t slot = (offset % span_bytes) / sizeof(T);
+        ptr->~T(); // Explicitly call the destructor
+        bits_of(phys)[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+        if (physicals[phys].live-- == block_size) {
+            partial.push_back(phys);
+        }
+    }
+
+    // Merge pairs of non-overlapping blocks that are at most half full.
+    // Objects must not be accessed by other threads while this runs.
+    // Returns the number of blocks whose physical pages were released.
+    size_t mesh(size_t max_probes = 64) {
+        EventScope<> event("mesh", this);
+        std::vector<uint32_t> candidates;
+        for (uint32_t phys = 0; phys < physicals.size(); ++phys) {
+            if (physicals[phys].alive && physicals[phys].live > 0 && physicals[phys].live <= block_size / 2) {
+                candidates.push_back(phys);
+            }
+        }
+        std::vector<bool> merged(candidates.size(), false);
+        size_t released = 0;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (merged[i]) {
+                continue;
+            }
+            size_t end = std::min(candidates.size(), i + 1 + max_probes);
+            for (size_t j = i + 1; j < end; ++j) {
+                uint32_t dst = candidates[i];
+                uint32_t src = candidates[j];
+                if (!merged[j] && physicals[dst].live + physicals[src].live <= block_size &&
+                    disjoint(dst, src) && merge(dst, src)) {
+                    merged[i] = merged[j] = true;
+                    ++released;
+                    break;
+                }
+            }
+        }
+        event.set_bytes(released * span_bytes);
+        return released;
+    }
+
+    // Physical memory currently backing blocks
+    [[nodiscard]] size_t resident_bytes() const noexcept {
+        return (physicals.size() - dead.size()) * span_bytes;
+    }
+
+    // Destructor to destroy live objects and release the mappings
+    ~MeshingBlockAllocator() {
+        for (uint32_t phys = 0; phys < physicals.size(); ++phys) {
+            if (!physicals[phys].alive) {
+                continue;
+            }
+            T* objects = reinterpret_cast<T*>(view_address(physicals[phys].views[0]));
+            const uint64_t* bits = bits_of(phys);
+            for (size_t w = 0; w < words; ++w) {
+                for (uint64_t live = bits[w]; live; live &= live - 1) {
+                    objects[w * 64 + std::countr_zero(live)].~T();
+                }
+            }
+        }
+        munmap(base, span_bytes * max_views);
+        close(fd);
+    }
+};
+
+#endif // defined(__linux__)
+
 } // namespace allocator
 
 #endif // ALLOCATOR_HPP
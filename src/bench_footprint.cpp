@@ -0,0 +1,248 @@
+// bench_footprint.cpp
+//
+// Memory footprint over time. Each allocator runs a workload that ramps up,
+// churns, drains to 10% and churns again, while the harness samples RSS,
+// the bytes the program requested, the bytes the allocator reports live and
+// the bytes it holds. Output is one CSV time series per allocator:
+//
+//   workload,allocator,op,rss_kib,requested,allocator_live,held,internal_frag,overhead
+//
+// internal_frag = 1 - requested / allocator_live (rounding and headers);
+// overhead = held / requested. Held bytes are pool blocks for the pools,
+// the highest address used for region heaps, and mallinfo2 arena plus
+// mmapped bytes for malloc.
+//
+// Build: g++ -std=c++20 -O2 -Iinclude src/bench_footprint.cpp -o bench_footprint
+// Use:   ./bench_footprint > footprint.csv
+
+#define ALLOCATOR_STATS
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "cpp_minallocator.hpp"
+
+namespace {
+
+using namespace allocator;
+
+constexpr size_t region_size = size_t(512) << 20;
+constexpr size_t peak_objects = 200'000;
+constexpr size_t churn_ops = 400'000;
+constexpr size_t sample_every = 5'000;
+
+// Value of a "Vm...:" line of /proc/self/status, in KiB
+size_t proc_status_kib(const char* key) {
+    std::FILE* status = std::fopen("/proc/self/status", "r");
+    if (!status) {
+        return 0;
+    }
+    char line[256];
+    size_t value = 0;
+    size_t key_length = std::strlen(key);
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::strncmp(line, key, key_length) == 0) {
+            value = std::strtoull(line + key_length, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(status);
+    return value;
+}
+
+// Adapters: allocate/deallocate plus the allocator's own view of live and held bytes
+
+struct Malloc {
+    void* allocate(size_t size) { return std::malloc(size); }
+    void deallocate(void* p, size_t) { std::free(p); }
+    size_t allocator_live() const {
+        struct mallinfo2 info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+    }
+    size_t held() const {
+        struct mallinfo2 info = mallinfo2();
+        return info.arena + info.hblkhd;
+    }
+};
+
+// Heaps over one region; held is the highest address ever handed out
+template<typename Heap>
+struct Region {
+    Heap heap;
+    uint8_t* region = static_cast<uint8_t*>(std::malloc(region_size));
+    size_t extent = 0;
+
+    Region() { heap.init(region, region_size); }
+    ~Region() { std::free(region); }
+
+    void* allocate(size_t size) {
+        auto* p = static_cast<uint8_t*>(heap.allocate_bytes(size));
+        if (p) {
+            extent = std::max(extent, size_t(p + size - region));
+        }
+        return p;
+    }
+    void deallocate(void* p, size_t size) { heap.deallocate_bytes(p, size); }
+    size_t allocator_live() const { return heap.stats().bytes_live; }
+    size_t held() const { return extent; }
+};
+
+template<size_t size>
+struct Object {
+    unsigned char bytes[size];
+};
+
+template<size_t size>
+struct Block {
+    using Allocator = BlockAllocator<Object<size>>;
+    Allocator heap;
+    void* allocate(size_t) { return heap.allocate(); }
+    void deallocate(void* p, size_t) { heap.free(static_cast<Object<size>*>(p)); }
+    size_t allocator_live() const { return heap.stats().bytes_live; }
+    size_t held() const { return heap.stats().blocks * Allocator::Pool::slot_size * 256; }
+};
+
+// Size classes from fixed-size pools, up to 1024 bytes
+struct Pools {
+    Segregator<32, FixedSizePool<32, 16>,
+    Segregator<64, FixedSizePool<64, 16>,
+    Segregator<128, FixedSizePool<128, 16>,
+    Segregator<256, FixedSizePool<256, 16>,
+    Segregator<512, FixedSizePool<512, 16>, FixedSizePool<1024, 16>>>>>> heap;
+
+    void* allocate(size_t size) { return heap.allocate_bytes(size); }
+    void deallocate(void* p, size_t size) { heap.deallocate_bytes(p, size); }
+
+    template<typename F>
+    void each_pool(F&& f) {
+        f(heap.small().stats(), size_t(32));
+        f(heap.large().small().stats(), size_t(64));
+        f(heap.large().large().small().stats(), size_t(128));
+        f(heap.large().large().large().small().stats(), size_t(256));
+        f(heap.large().large().large().large().small().stats(), size_t(512));
+        f(heap.large().large().large().large().large().stats(), size_t(1024));
+    }
+    size_t allocator_live() {
+        size_t total = 0;
+        each_pool([&](const AllocatorStats& s, size_t) { total += s.bytes_live; });
+        return total;
+    }
+    size_t held() {
+        size_t total = 0;
+        each_pool([&](const AllocatorStats& s, size_t slot) { total += s.blocks * slot * 256; });
+        return total;
+    }
+};
+
+struct Slot {
+    void* ptr = nullptr;
+    size_t size = 0;
+};
+
+// Runs the four-phase workload, printing a sample every `sample_every` operations
+template<typename Heap, typename SizeFn>
+void workload(const char* workload_name, const char* name, SizeFn&& next_size) {
+    std::fflush(stdout);
+    pid_t child = fork();
+    if (child != 0) {
+        waitpid(child, nullptr, 0);
+        return;
+    }
+    std::vector<Slot> slots(peak_objects);
+    std::mt19937_64 rng(11);
+    size_t rss_before = proc_status_kib("VmRSS:");
+    static Heap heap;
+    size_t requested = 0;
+    size_t live = 0;
+    size_t op = 0;
+
+    auto sample = [&] {
+        size_t allocator_live = heap.allocator_live();
+        size_t held = heap.held();
+        size_t rss = proc_status_kib("VmRSS:");
+        std::printf("%s,%s,%zu,%zu,%zu,%zu,%zu,%.4f,%.4f\n", workload_name, name, op,
+                    rss - std::min(rss, rss_before), requested, allocator_live, held,
+                    allocator_live ? 1.0 - double(requested) / double(allocator_live) : 0.0,
+                    requested ? double(held) / double(requested) : 0.0);
+    };
+    auto step = [&] {
+        if (++op % sample_every == 0) {
+            sample();
+        }
+    };
+    auto fill = [&](Slot& slot) {
+        slot.size = next_size(rng);
+        slot.ptr = heap.allocate(slot.size);
+        std::memset(slot.ptr, 1, std::min<size_t>(slot.size, 16));
+        requested += slot.size;
+        ++live;
+        step();
+    };
+    auto release = [&](Slot& slot) {
+        heap.deallocate(slot.ptr, slot.size);
+        requested -= slot.size;
+        slot.ptr = nullptr;
+        --live;
+        step();
+    };
+    auto churn = [&](size_t population) {
+        for (size_t i = 0; i < churn_ops / 2; ++i) {
+            Slot& slot = slots[rng() % population];
+            if (slot.ptr) {
+                release(slot);
+            }
+            fill(slot);
+        }
+    };
+
+    for (Slot& slot : slots) {
+        fill(slot);
+    }
+    churn(peak_objects);
+    for (Slot& slot : slots) {
+        if (slot.ptr && rng() % 10 != 0) {
+            release(slot);
+        }
+    }
+    // Pack the survivors to the front and churn at the low level, which shows
+    // whether freed memory is reused or returned
+    size_t low = 0;
+    for (Slot& slot : slots) {
+        if (slot.ptr) {
+            std::swap(slots[low++], slot);
+        }
+    }
+    churn(low);
+    sample();
+    std::fflush(stdout);
+    std::_Exit(0);
+}
+
+size_t mixed_size(std::mt19937_64& rng) {
+    return (size_t(16) << (rng() % 7)) - rng() % 16; // 1 to 1024 bytes, skewed small
+}
+
+} // namespace
+
+int main() {
+    std::printf("workload,allocator,op,rss_kib,requested,allocator_live,held,internal_frag,overhead\n");
+
+    auto fixed = [](std::mt19937_64&) { return size_t(48); };
+    workload<Malloc>("fixed48", "malloc", fixed);
+    workload<Block<48>>("fixed48", "block", fixed);
+    workload<Region<TlsfAllocator>>("fixed48", "tlsf", fixed);
+
+    workload<Malloc>("mixed", "malloc", mixed_size);
+    workload<Pools>("mixed", "pools", mixed_size);
+    workload<Region<TlsfAllocator>>("mixed", "tlsf", mixed_size);
+    workload<Region<FreeListAllocator<FitPolicy::BestFit, FreeIndex::SizeSegregated>>>("mixed", "freelist", mixed_size);
+    workload<Region<LinearAllocator>>("mixed", "linear", mixed_size);
+    return 0;
+}
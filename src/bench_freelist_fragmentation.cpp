@@ -0,0 +1,191 @@
+// bench_freelist_fragmentation.cpp
+//
+// Speed versus fragmentation of the FreeListAllocator fit policies and free
+// indexes, with TlsfAllocator and LinearAllocator as reference points. All
+// allocators replay the same trace: one recorded with TraceWriter (e.g. by
+// trace_preload) when a file is given, otherwise a synthetic mix of short-
+// and long-lived allocations.
+//
+// Build: g++ -std=c++20 -O2 -Iinclude src/bench_freelist_fragmentation.cpp -o bench_freelist_fragmentation
+// Use:   ./bench_freelist_fragmentation [trace-file]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "cpp_minallocator.hpp"
+
+namespace {
+
+constexpr size_t region_size = size_t(256) << 20;
+constexpr size_t operations = 400'000;
+
+struct Op {
+    bool alloc;
+    size_t size;   // Request size for allocations
+    size_t id;     // Allocation this event refers to
+};
+
+// Short-lived small objects interleaved with long-lived buffers, the pattern
+// that splits the heap into holes
+std::vector<Op> make_trace() {
+    std::mt19937_64 rng(7);
+    std::vector<Op> ops;
+    std::vector<std::pair<size_t, size_t>> pending; // (free at step, id)
+    size_t next_id = 0;
+    for (size_t step = 0; ops.size() < operations; ++step) {
+        bool long_lived = rng() % 8 == 0;
+        size_t size = long_lived ? 256 + rng() % 8192 : 16 + rng() % 240;
+        size_t lifetime = long_lived ? 1000 + rng() % 50000 : 1 + rng() % 200;
+        ops.push_back({true, size, next_id});
+        pending.push_back({step + lifetime, next_id++});
+        std::push_heap(pending.begin(), pending.end(), std::greater<>());
+        while (!pending.empty() && pending.front().first <= step) {
+            std::pop_heap(pending.begin(), pending.end(), std::greater<>());
+            ops.push_back({false, 0, pending.back().second});
+            pending.pop_back();
+        }
+    }
+    return ops;
+}
+
+// Convert a recorded trace; a reallocation becomes a free and a new
+// allocation under the same id, a reset frees everything live
+bool load_trace(const char* path, std::vector<Op>& ops) {
+    std::FILE* in = std::fopen(path, "rb");
+    if (!in) {
+        std::perror(path);
+        return false;
+    }
+    allocator::TraceReader reader(in);
+    std::fclose(in);
+    if (!reader.ok()) {
+        std::fprintf(stderr, "%s: not an allocation trace\n", path);
+        return false;
+    }
+    std::vector<bool> live;
+    for (allocator::TraceEvent event; reader.next(event);) {
+        size_t id = size_t(event.id);
+        if (id >= live.size()) {
+            live.resize(id + 1);
+        }
+        switch (event.op) {
+        case allocator::TraceOp::Allocate:
+            ops.push_back({true, size_t(event.size), id});
+            live[id] = true;
+            break;
+        case allocator::TraceOp::Free:
+            ops.push_back({false, 0, id});
+            live[id] = false;
+            break;
+        case allocator::TraceOp::Reallocate:
+            ops.push_back({false, 0, id});
+            ops.push_back({true, size_t(event.size), id});
+            live[id] = true;
+            break;
+        case allocator::TraceOp::Reset:
+            for (size_t i = 0; i < live.size(); ++i) {
+                if (live[i]) {
+                    ops.push_back({false, 0, i});
+                    live[i] = false;
+                }
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+struct Result {
+    double ns_per_op = 0;
+    size_t failed = 0;
+    size_t footprint = 0;   // Highest byte touched, relative to the region start
+};
+
+template<typename Alloc, typename Free>
+Result replay(const std::vector<Op>& ops, const uint8_t* base, Alloc&& alloc, Free&& release) {
+    size_t ids = 0;
+    for (const Op& op : ops) {
+        ids = std::max(ids, op.id + 1);
+    }
+    std::vector<std::pair<uint8_t*, size_t>> live(ids, {nullptr, 0});
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+    for (const Op& op : ops) {
+        if (op.alloc) {
+            uint8_t* p = alloc(op.size);
+            live[op.id] = {p, op.size};
+            if (!p) {
+                ++result.failed;
+            }
+        } else if (uint8_t* p = live[op.id].first) {
+            release(p, live[op.id].second);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    result.ns_per_op = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / double(ops.size());
+    for (auto [p, size] : live) {
+        if (p) {
+            result.footprint = std::max(result.footprint, size_t(p + size - base));
+        }
+    }
+    return result;
+}
+
+template<typename Heap>
+void run_heap(const char* name, const std::vector<Op>& ops, uint8_t* region) {
+    Heap heap;
+    heap.init(region, region_size);
+    size_t footprint = 0;
+    Result r = replay(ops, region,
+        [&](size_t size) {
+            uint8_t* p = heap.allocate(size);
+            if (p) {
+                footprint = std::max(footprint, size_t(p + size - region));
+            }
+            return p;
+        },
+        [&](uint8_t* p, size_t) { heap.free(p); });
+    r.footprint = footprint;
+    std::printf("%-28s %8.1f ns/op  peak footprint %8zu KiB  failed %zu\n",
+                name, r.ns_per_op, r.footprint >> 10, r.failed);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    using namespace allocator;
+    std::vector<Op> ops;
+    if (argc > 1) {
+        if (!load_trace(argv[1], ops)) {
+            return 1;
+        }
+    } else {
+        ops = make_trace();
+    }
+    std::printf("%zu events\n", ops.size());
+    uint8_t* region = static_cast<uint8_t*>(std::malloc(region_size));
+
+    run_heap<FreeListAllocator<FitPolicy::FirstFit, FreeIndex::AddressOrdered>>("first-fit / address", ops, region);
+    run_heap<FreeListAllocator<FitPolicy::NextFit, FreeIndex::AddressOrdered>>("next-fit / address", ops, region);
+    run_heap<FreeListAllocator<FitPolicy::BestFit, FreeIndex::AddressOrdered>>("best-fit / address", ops, region);
+    run_heap<FreeListAllocator<FitPolicy::FirstFit, FreeIndex::SizeSegregated>>("first-fit / segregated", ops, region);
+    run_heap<FreeListAllocator<FitPolicy::NextFit, FreeIndex::SizeSegregated>>("next-fit / segregated", ops, region);
+    run_heap<FreeListAllocator<FitPolicy::BestFit, FreeIndex::SizeSegregated>>("best-fit / segregated", ops, region);
+    run_heap<TlsfAllocator>("tlsf", ops, region);
+
+    // A linear allocator never reuses memory: its footprint is the total volume allocated
+    LinearAllocator linear;
+    linear.init(region, region_size);
+    Result r = replay(ops, region,
+        [&](size_t size) { return linear.allocate(size); },
+        [](uint8_t*, size_t) {});
+    std::printf("%-28s %8.1f ns/op  peak footprint %8zu KiB  failed %zu\n",
+                "linear (no reuse)", r.ns_per_op, r.footprint >> 10, r.failed);
+
+    std::free(region);
+    return 0;
+}
@@ -0,0 +1,190 @@
+// bench_perf_ops.cpp
+//
+// Hardware counters per allocator operation: cycles, instructions, branch
+// misses, L1D and dTLB read misses for a LinearAllocator bump, a pool pop
+// (allocate) and push (free), pool block creation, and arena resets. Cheap
+// operations are counted in batches and divided; rare ones (block creation,
+// reset) are counted one at a time with the cost of an empty counting window
+// subtracted. Counters come from perf_event_open (perf_counters.hpp) and
+// print as "-" when the kernel refuses them; ns/op is always reported.
+//
+// Build: g++ -std=c++20 -O2 -Iinclude src/bench_perf_ops.cpp -o bench_perf_ops
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "cpp_minallocator.hpp"
+#include "perf_counters.hpp"
+
+namespace {
+
+using namespace allocator;
+using bench::Counter;
+
+constexpr size_t batch_ops = 1'000'000;
+constexpr size_t single_samples = 2'000;
+constexpr size_t counter_count = 5;
+
+// Keeps the compiler from dropping a result
+template<typename T>
+inline void keep(T const& value) {
+    asm volatile("" : : "g"(value) : "memory");
+}
+
+struct Totals {
+    double counts[counter_count] = {};
+    double ns = 0;
+};
+
+class Harness {
+    bench::PerfCounters<counter_count> perf{{Counter::Cycles, Counter::Instructions, Counter::BranchMisses,
+                                             Counter::L1DMisses, Counter::DTLBMisses}};
+    Totals empty_window; // Per-window cost of starting and stopping the counters
+
+    // Count one window around f and add it to totals
+    template<typename F>
+    void window(Totals& totals, F&& f) {
+        perf.start();
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        perf.stop();
+        for (size_t i = 0; i < counter_count; ++i) {
+            totals.counts[i] += double(perf.value(i));
+        }
+        totals.ns += double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+    void report(const char* name, const Totals& totals, double ops) const {
+        std::printf("%-22s %9.2f", name, std::max(totals.ns / ops, 0.0));
+        for (size_t i = 0; i < counter_count; ++i) {
+            if (perf.available(i)) {
+                std::printf(" %13.2f", std::max(totals.counts[i] / ops, 0.0));
+            } else {
+                std::printf(" %13s", "-");
+            }
+        }
+        std::printf("\n");
+    }
+
+public:
+    Harness() {
+        for (size_t i = 0; i < single_samples; ++i) {
+            window(empty_window, [] {});
+        }
+        for (double& count : empty_window.counts) {
+            count /= double(single_samples);
+        }
+        empty_window.ns /= double(single_samples);
+
+        std::printf("%-22s %9s", "operation", "ns/op");
+        for (size_t i = 0; i < counter_count; ++i) {
+            std::printf(" %13s", bench::counter_name(perf.counter(i)));
+        }
+        std::printf("\n");
+    }
+
+    // `op(i)` performs operation i of `ops`, all inside one counting window
+    template<typename Op>
+    void batch(const char* name, size_t ops, Op&& op) {
+        Totals totals;
+        window(totals, [&] {
+            for (size_t i = 0; i < ops; ++i) {
+                op(i);
+            }
+        });
+        report(name, totals, double(ops));
+    }
+
+    // setup() runs uncounted before each counted op() and teardown() after it
+    template<typename Setup, typename Op, typename Teardown>
+    void single(const char* name, Setup&& setup, Op&& op, Teardown&& teardown) {
+        Totals totals;
+        for (size_t i = 0; i < single_samples; ++i) {
+            setup();
+            window(totals, op);
+            teardown();
+        }
+        for (size_t i = 0; i < counter_count; ++i) {
+            totals.counts[i] -= empty_window.counts[i] * double(single_samples);
+        }
+        totals.ns -= empty_window.ns * double(single_samples);
+        report(name, totals, double(single_samples));
+    }
+};
+
+struct Object {
+    unsigned char bytes[64];
+};
+
+} // namespace
+
+int main() {
+    Harness harness;
+    constexpr size_t region_size = batch_ops * 64;
+    void* region = std::malloc(region_size);
+
+    // Bump allocation; the region is touched once first so page faults are not counted
+    LinearAllocator linear;
+    linear.init(region, region_size);
+    std::fill_n(static_cast<uint8_t*>(region), region_size, uint8_t(0));
+    harness.batch("linear allocate", batch_ops, [&](size_t) { keep(linear.allocate(32)); });
+    linear.reset();
+    harness.batch("linear allocate_bytes", batch_ops, [&](size_t) { keep(linear.allocate_bytes(24)); });
+
+    // Pool pop and push on a pool that already holds every block it needs
+    {
+        BlockAllocator<Object> pool;
+        std::vector<Object*> objects(batch_ops);
+        for (Object*& object : objects) {
+            object = pool.allocate();
+        }
+        for (Object* object : objects) {
+            pool.free(object);
+        }
+        harness.batch("block allocate (pop)", batch_ops, [&](size_t i) { objects[i] = pool.allocate(); });
+        harness.batch("block free (push)", batch_ops, [&](size_t i) { pool.free(objects[i]); });
+
+        FixedSizePool<64> raw;
+        for (size_t i = 0; i < batch_ops; ++i) {
+            objects[i] = static_cast<Object*>(raw.allocate());
+        }
+        for (Object* object : objects) {
+            raw.free(object);
+        }
+        harness.batch("fixed pool pop", batch_ops, [&](size_t i) { objects[i] = static_cast<Object*>(raw.allocate()); });
+        harness.batch("fixed pool push", batch_ops, [&](size_t i) { raw.free(objects[i]); });
+    }
+
+    // Block creation: the first allocation from an empty pool
+    {
+        FixedSizePool<64>* pool = nullptr;
+        void* slot = nullptr;
+        harness.single("pool block creation",
+            [&] { pool = new FixedSizePool<64>(); },
+            [&] { slot = pool->allocate(); },
+            [&] { pool->free(slot); delete pool; });
+    }
+
+    // Resets
+    harness.single("linear reset",
+        [&] { keep(linear.allocate(4096)); },
+        [&] { linear.reset(); },
+        [] {});
+    {
+        TlsfAllocator tlsf;
+        harness.single("tlsf reset",
+            [&] {
+                tlsf.init(region, region_size); // Fresh heap for every sample
+                keep(tlsf.allocate(4096));
+            },
+            [&] { tlsf.reset(); },
+            [] {});
+    }
+
+    std::free(region);
+    return 0;
+}
@@ -0,0 +1,87 @@
+// bench_soa.cpp
+//
+// Field-wise update loop over many records stored three ways: a
+// BlockAllocator pool of whole objects (AoS, iterated through the pointers it
+// returned), a contiguous std::vector of objects (AoS best case) and an
+// SoAPool iterated block by block through per-field spans.
+//
+// Build: g++ -std=c++20 -O3 -march=native -Iinclude src/bench_soa.cpp -o bench_soa
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "cpp_minallocator.hpp"
+
+namespace {
+
+constexpr size_t record_count = 1'000'000;
+constexpr int iterations = 50;
+constexpr float dt = 0.016f;
+
+// 64-byte record of which the update only touches x and vx
+struct Particle {
+    float x = 0, y = 0, z = 0;
+    float vx = 1, vy = 1, vz = 1;
+    float mass = 1, radius = 1;
+    uint32_t id = 0, flags = 0;
+    float color[6] = {};
+};
+
+template<typename F>
+double time_ns_per_record(F&& update) {
+    update(); // Warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        update();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) /
+           double(iterations) / double(record_count);
+}
+
+} // namespace
+
+int main() {
+    using namespace allocator;
+
+    BlockAllocator<Particle, 1024> pool;
+    std::vector<Particle*> pointers;
+    for (size_t i = 0; i < record_count; ++i) {
+        pointers.push_back(pool.allocate());
+    }
+    double aos_pool = time_ns_per_record([&] {
+        for (Particle* p : pointers) {
+            p->x += p->vx * dt;
+        }
+    });
+
+    std::vector<Particle> array(record_count);
+    double aos_array = time_ns_per_record([&] {
+        for (Particle& p : array) {
+            p.x += p.vx * dt;
+        }
+    });
+
+    // Same fields as Particle: x y z vx vy vz mass radius id flags color
+    using Fields = FieldList<float, float, float, float, float, float, float, float,
+                             uint32_t, uint32_t, std::array<float, 6>>;
+    SoAPool<Fields, 1024> soa;
+    for (size_t i = 0; i < record_count; ++i) {
+        (void)soa.push(0.f, 0.f, 0.f, 1.f, 1.f, 1.f, 1.f, 1.f, 0u, 0u, std::array<float, 6>{});
+    }
+    double soa_spans = time_ns_per_record([&] {
+        for (size_t b = 0; b < soa.block_count(); ++b) {
+            std::span<float> x = soa.block_span<0>(b);
+            std::span<float> vx = soa.block_span<3>(b);
+            for (size_t i = 0; i < x.size(); ++i) {
+                x[i] += vx[i] * dt;
+            }
+        }
+    });
+
+    std::printf("aos BlockAllocator  %6.3f ns/record\n", aos_pool);
+    std::printf("aos std::vector     %6.3f ns/record\n", aos_array);
+    std::printf("soa SoAPool spans   %6.3f ns/record\n", soa_spans);
+    return 0;
+}
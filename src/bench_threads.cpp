@@ -0,0 +1,350 @@
+// bench_threads.cpp
+//
+// Multithreaded allocator stress tests at 1 to N threads:
+//   larson      server simulation: random frees and reallocations over a
+//               per-thread slot array that is handed to another thread
+//               every epoch, so objects are freed by threads that did not
+//               allocate them
+//   threadtest  each thread allocates and frees batches of its own objects
+//   xmalloc     producer/consumer pairs: producers allocate, consumers free
+// Every allocator and thread count runs in a forked child so peak RSS is its own.
+//
+// Build: g++ -std=c++20 -O2 -pthread -Iinclude src/bench_threads.cpp -o bench_threads
+// Use:   ./bench_threads [max-threads]
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "cpp_minallocator.hpp"
+
+namespace {
+
+using namespace allocator;
+
+constexpr size_t ops_per_thread = 1'000'000;
+
+// Heaps are shared by all threads; allocate() also gets the calling thread's
+// index for allocators that keep per-thread state
+
+struct Malloc {
+    explicit Malloc(size_t) {}
+    void* allocate(size_t size, size_t) { return std::malloc(size); }
+    void deallocate(void* p, size_t) { std::free(p); }
+};
+
+// A region-backed heap in the byte interface
+template<typename Heap, size_t region_size>
+struct RegionHeap {
+    Heap heap;
+    void* region = std::malloc(region_size);
+
+    RegionHeap() { heap.init(region, region_size); }
+    ~RegionHeap() { std::free(region); }
+
+    void* allocate_bytes(size_t size) noexcept { return heap.allocate_bytes(size); }
+    void deallocate_bytes(void* ptr, size_t size) noexcept { heap.deallocate_bytes(ptr, size); }
+    bool owns(const void* ptr) const noexcept { return heap.owns(ptr); }
+};
+
+using SizeClassPools =
+    Segregator<32, FixedSizePool<32, 16>,
+    Segregator<64, FixedSizePool<64, 16>,
+    Segregator<128, FixedSizePool<128, 16>,
+    Segregator<256, FixedSizePool<256, 16>,
+    Segregator<512, FixedSizePool<512, 16>, DefaultUpstream>>>>>;
+
+// One allocator behind one lock, shared by every thread
+template<typename A>
+struct Shared {
+    std::unique_ptr<LockedAllocator<A>> heap = std::make_unique<LockedAllocator<A>>();
+    explicit Shared(size_t) {}
+    void* allocate(size_t size, size_t) { return heap->allocate_bytes(size); }
+    void deallocate(void* p, size_t size) { heap->deallocate_bytes(p, size); }
+};
+
+// One locked TLSF arena per thread: allocations take the caller's arena (an
+// uncontended lock), frees find the owning arena by address
+struct Arenas {
+    using Arena = LockedAllocator<RegionHeap<TlsfAllocator, (size_t(64) << 20)>>;
+    std::vector<std::unique_ptr<Arena>> arenas;
+
+    explicit Arenas(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            arenas.push_back(std::make_unique<Arena>());
+        }
+    }
+
+    void* allocate(size_t size, size_t thread) { return arenas[thread]->allocate_bytes(size); }
+
+    void deallocate(void* p, size_t size) {
+        for (auto& arena : arenas) {
+            if (arena->inner().heap.owns(p)) { // Arena bounds never change; no lock needed
+                arena->deallocate_bytes(p, size);
+                return;
+            }
+        }
+    }
+};
+
+size_t random_size(std::mt19937_64& rng, size_t min, size_t max) {
+    return min + rng() % (max - min + 1);
+}
+
+struct Slot {
+    void* ptr = nullptr;
+    size_t size = 0;
+};
+
+// Returns the number of allocator operations performed
+template<typename Heap>
+size_t larson(Heap& heap, size_t threads) {
+    constexpr size_t slots_per_thread = 1000;
+    constexpr size_t epochs = 10;
+    std::vector<std::vector<Slot>> slots(threads, std::vector<Slot>(slots_per_thread));
+    std::barrier sync{std::ptrdiff_t(threads)};
+    auto worker = [&](size_t t) {
+        std::mt19937_64 rng(t + 1);
+        for (size_t epoch = 0; epoch < epochs; ++epoch) {
+            // Take over another thread's slots from the previous epoch
+            std::vector<Slot>& mine = slots[(t + epoch) % threads];
+            for (size_t i = 0; i < ops_per_thread / epochs / 2; ++i) {
+                Slot& slot = mine[rng() % slots_per_thread];
+                if (slot.ptr) {
+                    heap.deallocate(slot.ptr, slot.size);
+                }
+                slot.size = random_size(rng, 16, 512);
+                slot.ptr = heap.allocate(slot.size, t);
+                std::memset(slot.ptr, 1, 8);
+            }
+            sync.arrive_and_wait();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    for (auto& thread_slots : slots) {
+        for (Slot& slot : thread_slots) {
+            if (slot.ptr) {
+                heap.deallocate(slot.ptr, slot.size);
+            }
+        }
+    }
+    return threads * (ops_per_thread / epochs / 2) * epochs * 2;
+}
+
+template<typename Heap>
+size_t threadtest(Heap& heap, size_t threads) {
+    constexpr size_t batch = 100;
+    constexpr size_t size = 64;
+    auto worker = [&](size_t t) {
+        void* objects[batch];
+        for (size_t round = 0; round < ops_per_thread / (2 * batch); ++round) {
+            for (void*& p : objects) {
+                p = heap.allocate(size, t);
+                std::memset(p, 1, 8);
+            }
+            for (void* p : objects) {
+                heap.deallocate(p, size);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    return threads * (ops_per_thread / (2 * batch)) * batch * 2;
+}
+
+// Producers hand batches of objects to their consumer through a locked
+// queue; a single thread plays both roles
+template<typename Heap>
+size_t xmalloc(Heap& heap, size_t threads) {
+    constexpr size_t batch = 256;
+    constexpr size_t size_max = 256;
+    using Batch = std::vector<Slot>;
+
+    struct Channel {
+        std::mutex mutex;
+        std::deque<Batch> batches;
+        bool done = false;
+    };
+
+    size_t pairs = std::max<size_t>(threads / 2, 1);
+    size_t batches_per_producer = ops_per_thread / batch;
+    std::vector<Channel> channels(pairs);
+
+    auto produce = [&](size_t t, Channel& channel, std::mt19937_64& rng) {
+        Batch objects(batch);
+        for (Slot& slot : objects) {
+            slot.size = random_size(rng, 16, size_max);
+            slot.ptr = heap.allocate(slot.size, t);
+            std::memset(slot.ptr, 1, 8);
+        }
+        std::lock_guard<std::mutex> guard(channel.mutex);
+        channel.batches.push_back(std::move(objects));
+    };
+    auto release = [&](Batch& objects) {
+        for (Slot& slot : objects) {
+            heap.deallocate(slot.ptr, slot.size);
+        }
+    };
+
+    if (threads == 1) {
+        std::mt19937_64 rng(1);
+        for (size_t i = 0; i < batches_per_producer; ++i) {
+            produce(0, channels[0], rng);
+            release(channels[0].batches.front());
+            channels[0].batches.pop_front();
+        }
+        return batches_per_producer * batch * 2;
+    }
+
+    std::vector<std::thread> pool;
+    for (size_t pair = 0; pair < pairs; ++pair) {
+        pool.emplace_back([&, pair] {
+            std::mt19937_64 rng(pair + 1);
+            for (size_t i = 0; i < batches_per_producer; ++i) {
+                produce(2 * pair, channels[pair], rng);
+            }
+            std::lock_guard<std::mutex> guard(channels[pair].mutex);
+            channels[pair].done = true;
+        });
+        pool.emplace_back([&, pair] {
+            Channel& channel = channels[pair];
+            for (;;) {
+                Batch objects;
+                {
+                    std::lock_guard<std::mutex> guard(channel.mutex);
+                    if (channel.batches.empty()) {
+                        if (channel.done) {
+                            return;
+                        }
+                    } else {
+                        objects = std::move(channel.batches.front());
+                        channel.batches.pop_front();
+                    }
+                }
+                if (objects.empty()) {
+                    std::this_thread::yield();
+                } else {
+                    release(objects);
+                }
+            }
+        });
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    return pairs * batches_per_producer * batch * 2;
+}
+
+// Value of a "Vm...:" line of /proc/self/status, in KiB
+size_t proc_status_kib(const char* key) {
+    std::FILE* status = std::fopen("/proc/self/status", "r");
+    if (!status) {
+        return 0;
+    }
+    char line[256];
+    size_t value = 0;
+    size_t key_length = std::strlen(key);
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::strncmp(line, key, key_length) == 0) {
+            value = std::strtoull(line + key_length, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(status);
+    return value;
+}
+
+struct Result {
+    double mops = 0;        // Million allocator operations per second
+    size_t peak_rss = 0;    // KiB above the child's starting RSS
+};
+
+// Runs one benchmark in a forked child and collects its result over a pipe
+template<typename Heap, typename Bench>
+Result measure(Bench bench, size_t threads) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return {};
+    }
+    pid_t child = fork();
+    if (child == 0) {
+        close(fds[0]);
+        size_t rss_before = proc_status_kib("VmRSS:");
+        Heap heap(threads);
+        auto start = std::chrono::steady_clock::now();
+        size_t ops = bench(heap, threads);
+        auto end = std::chrono::steady_clock::now();
+        Result r;
+        r.mops = double(ops) / double(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+        r.peak_rss = proc_status_kib("VmHWM:") - rss_before;
+        if (write(fds[1], &r, sizeof(r)) != sizeof(r)) {
+            std::_Exit(1);
+        }
+        std::_Exit(0);
+    }
+    close(fds[1]);
+    Result r;
+    if (read(fds[0], &r, sizeof(r)) != sizeof(r)) {
+        r = {};
+    }
+    close(fds[0]);
+    waitpid(child, nullptr, 0);
+    return r;
+}
+
+template<typename Heap>
+void run(const char* bench_name, const char* heap_name, size_t max_threads) {
+    double base = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        Result r;
+        if (std::strcmp(bench_name, "larson") == 0) {
+            r = measure<Heap>([](Heap& h, size_t n) { return larson(h, n); }, threads);
+        } else if (std::strcmp(bench_name, "threadtest") == 0) {
+            r = measure<Heap>([](Heap& h, size_t n) { return threadtest(h, n); }, threads);
+        } else {
+            r = measure<Heap>([](Heap& h, size_t n) { return xmalloc(h, n); }, threads);
+        }
+        if (threads == 1) {
+            base = r.mops;
+        }
+        std::printf("%-11s %-14s %3zu threads  %8.2f Mops/s  scaling %5.2fx  peak RSS %8zu KiB\n",
+                    bench_name, heap_name, threads, r.mops, base > 0 ? r.mops / base : 0.0, r.peak_rss);
+        std::fflush(stdout);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t max_threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10)
+                                  : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    for (const char* bench : {"larson", "threadtest", "xmalloc"}) {
+        run<Malloc>(bench, "malloc", max_threads);
+        run<Shared<RegionHeap<TlsfAllocator, (size_t(256) << 20)>>>(bench, "locked-tlsf", max_threads);
+        run<Shared<SizeClassPools>>(bench, "locked-pools", max_threads);
+        run<Arenas>(bench, "tlsf-arenas", max_threads);
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+// bench_tlsf_latency.cpp
+//
+// Latency distribution of TlsfAllocator against malloc under a random
+// allocate/free mix. Every operation is timed individually so the tail
+// (p99.99, max) is visible rather than averaged away.
+//
+// Build: g++ -std=c++20 -O2 -Iinclude src/bench_tlsf_latency.cpp -o bench_tlsf_latency
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "cpp_minallocator.hpp"
+
+namespace {
+
+constexpr size_t region_size = size_t(64) << 20;
+constexpr size_t operations = 2'000'000;
+constexpr size_t max_live = 20'000;
+
+struct Op {
+    bool alloc;
+    size_t size;   // Request size for allocations
+    size_t slot;   // Live-set slot to fill or release
+};
+
+// Pre-generate the workload so both allocators see the identical sequence
+std::vector<Op> make_workload() {
+    std::mt19937_64 rng(42);
+    std::vector<Op> ops;
+    ops.reserve(operations);
+    std::vector<size_t> live;
+    std::vector<size_t> free_slots;
+    for (size_t i = max_live; i-- > 0;) {
+        free_slots.push_back(i);
+    }
+    for (size_t i = 0; i < operations; ++i) {
+        bool alloc = live.empty() || (free_slots.size() > 0 && rng() % 2 == 0);
+        if (alloc) {
+            // Mostly small requests with an occasional large buffer
+            size_t size = rng() % 16 == 0 ? 1024 + rng() % 16384 : 8 + rng() % 248;
+            size_t slot = free_slots.back();
+            free_slots.pop_back();
+            live.push_back(slot);
+            ops.push_back({true, size, slot});
+        } else {
+            size_t index = rng() % live.size();
+            size_t slot = live[index];
+            live[index] = live.back();
+            live.pop_back();
+            free_slots.push_back(slot);
+            ops.push_back({false, 0, slot});
+        }
+    }
+    return ops;
+}
+
+template<typename Alloc, typename Free>
+std::vector<uint32_t> run(const std::vector<Op>& ops, Alloc&& alloc, Free&& release) {
+    using clock = std::chrono::steady_clock;
+    std::vector<void*> slots(max_live, nullptr);
+    std::vector<uint32_t> samples;
+    samples.reserve(ops.size());
+    for (const Op& op : ops) {
+        auto start = clock::now();
+        if (op.alloc) {
+            slots[op.slot] = alloc(op.size);
+        } else {
+            release(slots[op.slot]);
+            slots[op.slot] = nullptr;
+        }
+        auto end = clock::now();
+        samples.push_back(uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    }
+    for (void* p : slots) {
+        if (p) {
+            release(p);
+        }
+    }
+    return samples;
+}
+
+void report(const char* name, std::vector<uint32_t> samples) {
+    std::sort(samples.begin(), samples.end());
+    auto pct = [&](double p) { return samples[size_t(p * double(samples.size() - 1))]; };
+    std::printf("%-8s p50 %6u ns  p99 %6u ns  p99.9 %6u ns  p99.99 %6u ns  max %8u ns\n",
+                name, pct(0.50), pct(0.99), pct(0.999), pct(0.9999), samples.back());
+}
+
+} // namespace
+
+int main() {
+    std::vector<Op> ops = make_workload();
+
+    // Touch the region up front, as a real-time thread would, so first-touch
+    // page faults are not charged to the allocator
+    void* region = std::malloc(region_size);
+    std::memset(region, 0, region_size);
+    allocator::TlsfAllocator tlsf;
+    tlsf.init(region, region_size);
+    report("tlsf", run(ops,
+        [&](size_t size) -> void* { return tlsf.allocate(size); },
+        [&](void* p) { tlsf.free(p); }));
+    std::free(region);
+
+    report("malloc", run(ops,
+        [](size_t size) { return std::malloc(size); },
+        [](void* p) { std::free(p); }));
+    return 0;
+}
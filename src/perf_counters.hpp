@@ -0,0 +1,144 @@
+// perf_counters.hpp
+//
+// Hardware counter group for the benchmarks, read with perf_event_open on
+// Linux. Counters the kernel refuses (perf_event_paranoid, containers, VMs
+// without a PMU) are reported as unavailable instead of failing the run.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+enum class Counter {
+    Cycles,
+    Instructions,
+    BranchMisses,
+    CacheMisses,    // Last-level cache
+    L1DMisses,
+    DTLBMisses,
+};
+
+constexpr const char* counter_name(Counter counter) noexcept {
+    switch (counter) {
+    case Counter::Cycles: return "cycles";
+    case Counter::Instructions: return "instructions";
+    case Counter::BranchMisses: return "branch-misses";
+    case Counter::CacheMisses: return "cache-misses";
+    case Counter::L1DMisses: return "L1D-misses";
+    case Counter::DTLBMisses: return "dTLB-misses";
+    }
+    return "?";
+}
+
+// Counts user-space events for the calling thread between start() and stop().
+// Each counter is opened separately, so one unsupported event does not
+// disable the others.
+template<size_t count>
+class PerfCounters {
+    std::array<Counter, count> counters;
+    std::array<int, count> fds;
+    std::array<uint64_t, count> values = {};
+
+#if defined(__linux__)
+    static void describe(Counter counter, perf_event_attr& attr) noexcept {
+        auto cache_event = [](uint64_t cache) {
+            return cache | (uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8) |
+                   (uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+        };
+        attr.type = PERF_TYPE_HARDWARE;
+        switch (counter) {
+        case Counter::Cycles: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case Counter::Instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case Counter::BranchMisses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case Counter::CacheMisses: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case Counter::L1DMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_event(PERF_COUNT_HW_CACHE_L1D);
+            break;
+        case Counter::DTLBMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_event(PERF_COUNT_HW_CACHE_DTLB);
+            break;
+        }
+    }
+
+    static int open(Counter counter) noexcept {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        describe(counter, attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+public:
+    explicit PerfCounters(const std::array<Counter, count>& events) noexcept : counters(events) {
+        for (size_t i = 0; i < count; ++i) {
+#if defined(__linux__)
+            fds[i] = open(counters[i]);
+#else
+            fds[i] = -1;
+#endif
+        }
+    }
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Whether counter i could be opened
+    [[nodiscard]] bool available(size_t i) const noexcept { return fds[i] >= 0; }
+
+    void start() noexcept {
+#if defined(__linux__)
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop() noexcept {
+#if defined(__linux__)
+        for (size_t i = 0; i < count; ++i) {
+            if (fds[i] >= 0) {
+                ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+                if (read(fds[i], &values[i], sizeof(values[i])) != sizeof(values[i])) {
+                    values[i] = 0;
+                }
+            }
+        }
+#endif
+    }
+
+    // Events counted by counter i in the last start()/stop() interval
+    [[nodiscard]] uint64_t value(size_t i) const noexcept { return values[i]; }
+
+    [[nodiscard]] Counter counter(size_t i) const noexcept { return counters[i]; }
+};
+
+} // namespace bench
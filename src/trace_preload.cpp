@@ -0,0 +1,161 @@
+// trace_preload.cpp
+//
+// LD_PRELOAD recorder: writes every malloc/calloc/realloc/free of an
+// arbitrary program as a TraceWriter trace, for offline replay with
+// trace_replay against the allocators in this library.
+//
+// Build: g++ -std=c++20 -O2 -fPIC -shared -Iinclude src/trace_preload.cpp -o libtrace_preload.so
+// Use:   ALLOCATOR_TRACE_FILE=app.trace LD_PRELOAD=./libtrace_preload.so ./app
+//
+// glibc only: the real allocator is reached through its __libc_* entry points,
+// which avoids dlsym (itself an allocating call) during start-up.
+
+#include <pthread.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "cpp_minallocator.hpp"
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+
+pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+alignas(allocator::TraceWriter) unsigned char writer_storage[sizeof(allocator::TraceWriter)];
+allocator::TraceWriter* writer = nullptr;
+bool disabled = false;
+
+// Set while this thread is inside the recorder, so the recorder's own
+// allocations (hash map growth, stdio buffers) are passed straight through
+thread_local bool in_recorder = false;
+
+// Holds the trace lock for the whole hooked call, so each libc call and its
+// record are serialized together and the trace orders them as the heap did.
+// Nested calls from the recorder itself take no lock and record nothing.
+class TraceScope {
+    bool owner;
+
+public:
+    TraceScope() : owner(!in_recorder) {
+        if (!owner) {
+            return;
+        }
+        in_recorder = true;
+        pthread_mutex_lock(&trace_lock);
+        if (!writer && !disabled) {
+            const char* path = std::getenv("ALLOCATOR_TRACE_FILE");
+            std::FILE* file = std::fopen(path ? path : "alloc.trace", "wb");
+            if (file) {
+                writer = new (writer_storage) allocator::TraceWriter(file);
+            } else {
+                disabled = true;
+            }
+        }
+    }
+
+    ~TraceScope() {
+        if (owner) {
+            pthread_mutex_unlock(&trace_lock);
+            in_recorder = false;
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    // Writer for this call; nullptr when the call is not recorded
+    [[nodiscard]] allocator::TraceWriter* trace() const noexcept {
+        return owner ? writer : nullptr;
+    }
+};
+
+__attribute__((destructor)) void flush_trace() {
+    in_recorder = true;
+    pthread_mutex_lock(&trace_lock);
+    if (writer) {
+        writer->flush();
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+} // namespace
+
+extern "C" {
+
+void* malloc(size_t size) {
+    TraceScope scope;
+    void* ptr = __libc_malloc(size);
+    if (ptr && scope.trace()) {
+        scope.trace()->on_allocate(ptr, size);
+    }
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size) {
+    TraceScope scope;
+    void* ptr = __libc_calloc(count, size);
+    if (ptr && scope.trace()) {
+        scope.trace()->on_allocate(ptr, count * size);
+    }
+    return ptr;
+}
+
+void* realloc(void* old_ptr, size_t size) {
+    TraceScope scope;
+    void* ptr = __libc_realloc(old_ptr, size);
+    allocator::TraceWriter* w = scope.trace();
+    if (!w) {
+        return ptr;
+    }
+    if (!old_ptr) {
+        if (ptr) {
+            w->on_allocate(ptr, size);
+        }
+    } else if (size == 0) {
+        w->on_free(old_ptr);
+    } else if (ptr) {
+        w->on_reallocate(old_ptr, ptr, size);
+    }
+    return ptr;
+}
+
+void free(void* ptr) {
+    TraceScope scope;
+    if (ptr && scope.trace()) {
+        scope.trace()->on_free(ptr);
+    }
+    __libc_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    TraceScope scope;
+    void* ptr = __libc_memalign(alignment, size);
+    if (ptr && scope.trace()) {
+        scope.trace()->on_allocate(ptr, size);
+    }
+    return ptr;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    void* ptr = memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+} // extern "C"
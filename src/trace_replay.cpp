@@ -0,0 +1,224 @@
+// trace_replay.cpp
+//
+// Replays an allocation trace (written by TraceWriter, TracingAllocator or
+// trace_preload) against malloc and the allocators in this library, and
+// reports throughput, peak live bytes and peak resident memory for each.
+// Every allocator runs in its own forked process so peak RSS is not shared.
+//
+// Build: g++ -std=c++20 -O2 -Iinclude src/trace_replay.cpp -o trace_replay
+// Use:   ./trace_replay app.trace [allocator...]
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "cpp_minallocator.hpp"
+
+namespace {
+
+using namespace allocator;
+
+constexpr size_t region_size = size_t(1) << 30; // Reserved, only touched pages become resident
+
+struct Result {
+    double ns_per_event = 0;
+    size_t failed = 0;
+    size_t peak_live = 0;   // Highest sum of requested bytes
+};
+
+// Value of a "Vm...:" line of /proc/self/status, in KiB
+size_t proc_status_kib(const char* key) {
+    std::FILE* status = std::fopen("/proc/self/status", "r");
+    if (!status) {
+        return 0;
+    }
+    char line[256];
+    size_t value = 0;
+    size_t key_length = std::strlen(key);
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::strncmp(line, key, key_length) == 0) {
+            value = std::strtoull(line + key_length, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(status);
+    return value;
+}
+
+// Replays on any RawAllocator; a Reset event calls a.reset() when the
+// allocator has one and frees every live allocation otherwise. `live` holds
+// one (pointer, size) entry per allocation id and is allocated by the caller
+// so it is not counted in the allocator's footprint.
+template<typename A>
+Result replay(const std::vector<TraceEvent>& events, std::vector<std::pair<void*, size_t>>& live, A& a) {
+    Result result;
+    size_t live_bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const TraceEvent& event : events) {
+        auto& [ptr, size] = live[event.id];
+        switch (event.op) {
+        case TraceOp::Allocate:
+            ptr = a.allocate_bytes(event.size);
+            size = ptr ? event.size : 0;
+            result.failed += !ptr;
+            live_bytes += size;
+            break;
+        case TraceOp::Free:
+            if (ptr) {
+                a.deallocate_bytes(ptr, size);
+                live_bytes -= size;
+                ptr = nullptr;
+            }
+            break;
+        case TraceOp::Reallocate: {
+            void* moved = a.allocate_bytes(event.size);
+            if (!moved) {
+                ++result.failed;
+                break;
+            }
+            if (ptr) {
+                std::memcpy(moved, ptr, std::min(size, size_t(event.size)));
+                a.deallocate_bytes(ptr, size);
+            }
+            live_bytes += event.size - size;
+            ptr = moved;
+            size = event.size;
+            break;
+        }
+        case TraceOp::Reset:
+            if constexpr (requires { a.reset(); }) {
+                a.reset();
+            }
+            for (auto& [live_ptr, live_size] : live) {
+                if constexpr (!requires { a.reset(); }) {
+                    if (live_ptr) {
+                        a.deallocate_bytes(live_ptr, live_size);
+                    }
+                }
+                live_ptr = nullptr;
+            }
+            live_bytes = 0;
+            break;
+        }
+        result.peak_live = std::max(result.peak_live, live_bytes);
+    }
+    auto end = std::chrono::steady_clock::now();
+    result.ns_per_event = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) /
+                          double(std::max<size_t>(events.size(), 1));
+    return result;
+}
+
+// Heaps that manage a caller-provided region, exposed through the byte interface
+template<typename Heap>
+struct RegionHeap {
+    Heap heap;
+    void* region = std::malloc(region_size);
+
+    RegionHeap() { heap.init(region, region_size); }
+    ~RegionHeap() { std::free(region); }
+
+    void* allocate_bytes(size_t size) noexcept { return heap.allocate_bytes(size); }
+    void deallocate_bytes(void* ptr, size_t size) noexcept { heap.deallocate_bytes(ptr, size); }
+    bool owns(const void* ptr) const noexcept { return heap.owns(ptr); }
+};
+
+struct LinearHeap : RegionHeap<LinearAllocator> {
+    void reset() noexcept { heap.reset(); }
+};
+
+// Size classes served from fixed-size pools, everything larger from malloc
+using SizeClassPools =
+    Segregator<16, FixedSizePool<16, 16>,
+    Segregator<32, FixedSizePool<32, 16>,
+    Segregator<64, FixedSizePool<64, 16>,
+    Segregator<128, FixedSizePool<128, 16>,
+    Segregator<256, FixedSizePool<256, 16>,
+    Segregator<512, FixedSizePool<512, 16>, DefaultUpstream>>>>>>;
+
+using Composite = Segregator<512, SizeClassPools,
+                  Segregator<LargeObjectAllocator::default_threshold - 1,
+                             FallbackAllocator<RegionHeap<TlsfAllocator>, DefaultUpstream>,
+                             LargeObjectAllocator>>;
+
+template<typename A>
+void run(const char* name, const std::vector<TraceEvent>& events, size_t id_count) {
+    std::fflush(stdout);
+    pid_t child = fork();
+    if (child != 0) {
+        int status = 0;
+        waitpid(child, &status, 0);
+        return;
+    }
+    std::vector<std::pair<void*, size_t>> live(id_count, {nullptr, 0});
+    size_t rss_before = proc_status_kib("VmRSS:");
+    static A a; // Some heaps are large; keep them off the stack
+    Result r = replay(events, live, a);
+    size_t rss_peak = proc_status_kib("VmHWM:") - rss_before;
+    std::printf("%-24s %8.1f ns/event  peak live %9zu KiB  peak RSS %9zu KiB  overhead %5.2fx  failed %zu\n",
+                name, r.ns_per_event, r.peak_live >> 10, rss_peak,
+                r.peak_live ? double(rss_peak << 10) / double(r.peak_live) : 0.0, r.failed);
+    std::fflush(stdout);
+    std::_Exit(0);
+}
+
+struct Candidate {
+    const char* name;
+    void (*run)(const char*, const std::vector<TraceEvent>&, size_t);
+};
+
+constexpr Candidate candidates[] = {
+    {"malloc", run<DefaultUpstream>},
+    {"tlsf", run<RegionHeap<TlsfAllocator>>},
+    {"freelist-first", run<RegionHeap<FreeListAllocator<FitPolicy::FirstFit, FreeIndex::AddressOrdered>>>},
+    {"freelist-best", run<RegionHeap<FreeListAllocator<FitPolicy::BestFit, FreeIndex::SizeSegregated>>>},
+    {"pools", run<SizeClassPools>},
+    {"composite", run<Composite>},
+    {"linear", run<LinearHeap>},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s trace-file [allocator...]\nallocators:", argv[0]);
+        for (const Candidate& c : candidates) {
+            std::fprintf(stderr, " %s", c.name);
+        }
+        std::fprintf(stderr, "\n");
+        return 1;
+    }
+    std::FILE* in = std::fopen(argv[1], "rb");
+    if (!in) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    TraceReader reader(in);
+    std::fclose(in);
+    if (!reader.ok()) {
+        std::fprintf(stderr, "%s: not an allocation trace\n", argv[1]);
+        return 1;
+    }
+    std::vector<TraceEvent> events;
+    size_t id_count = 0;
+    for (TraceEvent event; reader.next(event);) {
+        events.push_back(event);
+        id_count = std::max<size_t>(id_count, event.id + 1);
+    }
+    std::printf("%zu events, %zu allocations\n", events.size(), id_count);
+
+    for (const Candidate& c : candidates) {
+        bool selected = argc == 2;
+        for (int i = 2; i < argc; ++i) {
+            selected |= std::strcmp(argv[i], c.name) == 0;
+        }
+        if (selected) {
+            c.run(c.name, events, id_count);
+        }
+    }
+    return 0;
+}